@@ -38,7 +38,11 @@ For more information, please refer to <http://unlicense.org/>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <thread>
 #include <cstring>
+#include <cstdint>
 #include <cassert>
 
 namespace expr
@@ -58,12 +62,34 @@ enum class Error {
 template <std::size_t EXPR_SIZE = 256>
 class BoolExpression {
 public:
+	/* Historical: variables were once encoded as single chars 'A'..'Z', capping the count
+	 * at 26. Operands are now 16-bit indices in the compiled op stream, so this is no
+	 * longer a limit; it remains only for callers that sized buffers with it */
 	static constexpr int PARAM_MAX = 'Z' - 'A' + 1;
-	std::string m_vars[PARAM_MAX];
-	bool m_varVals[PARAM_MAX];
+
+	std::vector<std::string> m_vars;
+	std::vector<unsigned char> m_varVals;
 
 	char m_expr[EXPR_SIZE]; // Initial expression
-	char m_rpn[EXPR_SIZE];	// Resultant RPN expression
+
+	/* Compiled form of the expression: a flat op array with 16-bit operand indices,
+	 * evaluated without any string walking */
+	enum OpCode : unsigned char {
+		OP_PUSH = 0, // Push variable [var] onto the stack
+		OP_OR,
+		OP_AND,
+		OP_NOT,
+		OP_XOR,
+		OP_CONST // Push constant [var] (0 or 1); produced by fold()
+	};
+
+	struct Op {
+		unsigned char code;
+		unsigned short var; // Operand index for OP_PUSH
+	};
+
+	Op m_ops[EXPR_SIZE];
+	int m_numOps = 0;
 
 public:
 	BoolExpression(const char *expression);
@@ -85,11 +111,15 @@ public:
 	 * @brief Defines a variable's value
 	 * @param varName Name of the variable
 	 * @param value Value
-	 * @return int Index of the new or existing variable with that name. -1 is returned if max number of vars has been
-	 * reached
+	 * @return int Index of the new or existing variable with that name. -1 is returned only if the
+	 * 16-bit operand index space (65536 variables) is exhausted
 	 */
 	int define(const char *varName, bool value);
 
+	inline int numVars() const {
+		return (int)m_vars.size();
+	}
+
 	/**
 	 * @brief Defines a variable's value
 	 * @param varIndex Index of the variable.
@@ -98,13 +128,59 @@ public:
 	void set(int varIndex, bool value);
 
 	/**
-	 * @brief Parses the logical expression
+	 * @brief Parses the logical expression into the flat op array
 	 * @return Error
 	 */
 	Error parse();
 
 	Error eval(bool &result);
 
+	/**
+	 * @brief Ensures the op array is populated; parse() now emits ops directly, so this just
+	 * parses lazily if parse() was never called
+	 * @return Error
+	 */
+	Error compile();
+
+	/**
+	 * @brief Constant-folds the compiled ops against statically-known variable values
+	 *
+	 * AND/OR subtrees whose outcome is forced by a known operand are pruned entirely, XOR
+	 * against a known value becomes the other operand (negated if the value is true), and
+	 * fully-known subtrees collapse to a single OP_CONST. The folded ops replace the
+	 * compiled ones, so subsequent evals run the smaller program.
+	 *
+	 * @param knownVars Value per variable index; only read where isKnown is set
+	 * @param isKnown One flag per variable index; must have numVars() entries
+	 * @return Error. Parses on first use if parse() was not called explicitly
+	 */
+	Error fold(const bool *knownVars, const bool *isKnown);
+
+	/**
+	 * @brief Evaluates the compiled expression against many variable assignments
+	 * @param varMatrix Matrix of variable values; assignment i reads varMatrix[i * stride + v]
+	 * for variable index v
+	 * @param stride Number of bools per assignment row
+	 * @param results Receives one result per assignment
+	 * @param count Number of assignments
+	 * @return Error. Compiles on first use if compile() was not called explicitly
+	 */
+	Error evalMany(const bool *varMatrix, std::size_t stride, bool *results, std::size_t count);
+
+	/**
+	 * @brief Evaluates 64 assignments in one pass, one per bit lane
+	 *
+	 * Since every op is OR/AND/XOR/NOT over bools, packing each variable's value across 64
+	 * assignments into a uint64_t lets the whole batch run through word-wide |, &, ^ and ~
+	 * with a single walk of the compiled ops.
+	 *
+	 * @param varBits Bit i of varBits[v] holds variable index v's value in assignment i; must
+	 * have at least numVars() entries
+	 * @param resultBits Bit i receives the result of assignment i
+	 * @return Error. Compiles on first use if compile() was not called explicitly
+	 */
+	Error evalPacked(const std::uint64_t *varBits, std::uint64_t &resultBits);
+
 private:
 	inline int precedence(char c) const {
 		return (((c) == OR || (c) == XOR) ? 0 : (c) == AND ? 1 : 2);
@@ -112,21 +188,31 @@ private:
 	inline bool isOp(char c) const {
 		return (c == OR || c == AND || c == COM || c == NOT || c == XOR);
 	};
-	inline bool isVar(char x) const {
-		return (x <= 'Z' && x >= 'A');
-	}
 	inline bool isText(char x) const {
 		return ((x >= '0' && x <= '9') || (x >= 'A' && x <= 'Z') || (x >= 'a' && x <= 'z') || x == '_');
 	}
 	inline int varIndex(const char *s) const {
-		int i = 0;
-		for (const auto &v : m_vars) {
-			if (!std::strcmp(v.c_str(), s))
-				return i;
-			++i;
+		auto it = m_varMap.find(s);
+		return it != m_varMap.end() ? it->second : -1;
+	}
+	/* Maps an operator char onto its opcode, or -1 for anything else */
+	inline int opFromChar(char c) const {
+		switch (c) {
+		case OR:
+			return OP_OR;
+		case AND:
+			return OP_AND;
+		case COM:
+		case NOT:
+			return OP_NOT;
+		case XOR:
+			return OP_XOR;
+		default:
+			return -1;
 		}
-		return -1;
 	}
+
+	std::unordered_map<std::string, int> m_varMap;
 };
 
 template <std::size_t EXPR_SIZE>
@@ -151,35 +237,45 @@ inline BoolExpression<EXPR_SIZE>::BoolExpression(std::string_view expr) {
 
 template <std::size_t EXPR_SIZE>
 inline int BoolExpression<EXPR_SIZE>::define(const char *varName, bool value) {
-	for (int i = 0; i < PARAM_MAX; i++) {
-		if (m_vars[i].empty()) {
-			m_vars[i] = varName;
-			m_varVals[i] = value;
-			return i;
-		}
+	auto it = m_varMap.find(varName);
+	if (it != m_varMap.end()) {
+		m_varVals[it->second] = value;
+		return it->second;
 	}
-	return -1;
+	if (m_vars.size() > 0xFFFF)
+		return -1; /* Op::var is 16 bits */
+	int idx = (int)m_vars.size();
+	m_vars.push_back(varName);
+	m_varVals.push_back(value);
+	m_varMap.emplace(varName, idx);
+	return idx;
 }
 
 template <std::size_t EXPR_SIZE>
 inline void BoolExpression<EXPR_SIZE>::set(int varIndex, bool value) {
-	assert(varIndex >= 0 && varIndex <= PARAM_MAX);
+	assert(varIndex >= 0 && varIndex < (int)m_vars.size());
 	m_varVals[varIndex] = value;
 }
 
-/* Takes an expression in infix notation and converts it to RPN using the shunting yard algorithm */
+/* Takes an expression in infix notation and lowers it straight into the flat op array using the
+ * shunting yard algorithm. Operand tokens carry 16-bit variable indices, so there is no limit on
+ * variable count beyond the index width */
 template <std::size_t EXPR_SIZE>
 Error BoolExpression<EXPR_SIZE>::parse() {
-	std::size_t rpn_size = sizeof(m_rpn);
-	char *rpn = m_rpn;
 	const char *expr = m_expr;
 
-	char out_queue[256]; /* Output queue */
 	char opstack[256];
-	std::memset(out_queue, 0, sizeof(out_queue));
-
-	int queuei = 0;
 	int stacki = 0;
+	m_numOps = 0;
+
+	auto emitOp = [this](char c) -> bool {
+		if (m_numOps >= (int)EXPR_SIZE)
+			return false;
+		Op op = {};
+		op.code = (unsigned char)opFromChar(c);
+		m_ops[m_numOps++] = op;
+		return true;
+	};
 
 	const char *s = expr;
 	for (s = expr; s && *s; s++) {
@@ -190,16 +286,18 @@ Error BoolExpression<EXPR_SIZE>::parse() {
 			continue;
 		}
 		if (isOp(*s)) {
-			while (opstack[stacki - 1] != '(' && stacki > 0 && precedence(opstack[stacki - 1]) > precedence(*s)) {
-				out_queue[queuei++] = opstack[stacki - 1];
+			while (stacki > 0 && opstack[stacki - 1] != '(' && precedence(opstack[stacki - 1]) > precedence(*s)) {
+				if (!emitOp(opstack[stacki - 1]))
+					return Error::BufTooSmall;
 				stacki--;
 			}
 			opstack[stacki++] = *s;
 			continue;
 		}
 		if (*s == ')') {
-			while (opstack[stacki - 1] != '(' && stacki > 0) {
-				out_queue[queuei++] = opstack[stacki - 1];
+			while (stacki > 0 && opstack[stacki - 1] != '(') {
+				if (!emitOp(opstack[stacki - 1]))
+					return Error::BufTooSmall;
 				stacki--;
 			}
 			if (stacki <= 0 || opstack[stacki - 1] != '(')
@@ -221,95 +319,827 @@ Error BoolExpression<EXPR_SIZE>::parse() {
 			if (idx == -1) {
 				return Error::UndefinedVar;
 			}
-			out_queue[queuei++] = idx + 'A';
+			if (m_numOps >= (int)EXPR_SIZE)
+				return Error::BufTooSmall;
+			Op op = {};
+			op.code = OP_PUSH;
+			op.var = (unsigned short)idx;
+			m_ops[m_numOps++] = op;
+			s = z - 1;
 			continue;
 		}
 
-		//	if (IS_VAR(*s)) {
-		//		out_queue[queuei++] = *s;
-		//		continue;
-		//	}
 		return Error::BadToken;
 	}
 	while (stacki > 0) {
-		out_queue[queuei++] = opstack[stacki - 1];
+		if (opstack[stacki - 1] != '(' && !emitOp(opstack[stacki - 1]))
+			return Error::BufTooSmall;
 		stacki--;
 	}
 
-	if (queuei >= rpn_size)
-		return Error::BufTooSmall;
-	std::strncpy(rpn, out_queue, queuei);
-	rpn[queuei] = 0;
-
 	return Error::OK;
 }
 
-/* Evaluates the boolean expression in RPN */
+/* Evaluates the compiled ops against the currently defined variable values */
 template <std::size_t EXPR_SIZE>
 Error BoolExpression<EXPR_SIZE>::eval(bool &result) {
-	const char *rpn = m_rpn;
-	bool varstack[256];
+	bool varstack[EXPR_SIZE];
 	int vstacki = 0;
 
-	auto opCheck = [](int vstacki, int n) -> bool {
-		if (vstacki < n) {
-			return false;
+	for (int i = 0; i < m_numOps; i++) {
+		const Op &op = m_ops[i];
+		switch (op.code) {
+		case OP_PUSH:
+			if (op.var >= m_varVals.size())
+				return Error::UndefinedVar;
+			varstack[vstacki++] = m_varVals[op.var];
+			break;
+		case OP_CONST:
+			varstack[vstacki++] = op.var != 0;
+			break;
+		case OP_OR:
+			if (vstacki < 2)
+				return Error::TooManyOps;
+			vstacki--;
+			varstack[vstacki - 1] = varstack[vstacki - 1] || varstack[vstacki];
+			break;
+		case OP_AND:
+			if (vstacki < 2)
+				return Error::TooManyOps;
+			vstacki--;
+			varstack[vstacki - 1] = varstack[vstacki - 1] && varstack[vstacki];
+			break;
+		case OP_NOT:
+			if (vstacki < 1)
+				return Error::TooManyOps;
+			varstack[vstacki - 1] = !varstack[vstacki - 1];
+			break;
+		case OP_XOR:
+			if (vstacki < 2)
+				return Error::TooManyOps;
+			vstacki--;
+			varstack[vstacki - 1] = varstack[vstacki - 1] ^ varstack[vstacki];
+			break;
+		default:
+			return Error::BadOp;
 		}
-		return true;
+	}
+
+	if (vstacki <= 0)
+		return Error::StackUnderflow;
+	result = varstack[vstacki - 1];
+	return Error::OK;
+}
+
+/* parse() emits ops directly now; this just parses lazily for callers that only ever called
+ * compile() before an eval */
+template <std::size_t EXPR_SIZE>
+Error BoolExpression<EXPR_SIZE>::compile() {
+	if (m_numOps > 0)
+		return Error::OK;
+	return parse();
+}
+
+/* Symbolically evaluates the ops with a stack of either constants or folded op sequences,
+ * then rewrites m_ops with whatever could not be resolved statically */
+template <std::size_t EXPR_SIZE>
+Error BoolExpression<EXPR_SIZE>::fold(const bool *knownVars, const bool *isKnown) {
+	if (m_numOps == 0) {
+		Error err = parse();
+		if (err != Error::OK)
+			return err;
+	}
+
+	struct Entry {
+		bool isConst;
+		bool value;
+		std::vector<Op> ops;
 	};
+	std::vector<Entry> stack;
 
-	const char *s;
-	for (s = rpn; s && *s; ++s) {
-		if (isVar(*s)) {
-			varstack[vstacki++] = m_varVals[*s - 'A']; // varvals[*s - 'A'];
-			continue;
+	for (int i = 0; i < m_numOps; i++) {
+		const Op &op = m_ops[i];
+		switch (op.code) {
+		case OP_PUSH: {
+			Entry e;
+			e.value = false;
+			if ((e.isConst = isKnown[op.var]))
+				e.value = knownVars[op.var];
+			else
+				e.ops.push_back(op);
+			stack.push_back(std::move(e));
+			break;
 		}
-		else if (isOp(*s)) {
-			bool a, b;
-			switch (*s) {
-			case OR:
-				if (!opCheck(vstacki, 2)) {
-					return Error::TooManyOps;
+		case OP_CONST: {
+			Entry e;
+			e.isConst = true;
+			e.value = op.var != 0;
+			stack.push_back(std::move(e));
+			break;
+		}
+		case OP_NOT: {
+			if (stack.size() < 1)
+				return Error::TooManyOps;
+			Entry &e = stack.back();
+			if (e.isConst)
+				e.value = !e.value;
+			else {
+				Op n = {};
+				n.code = OP_NOT;
+				e.ops.push_back(n);
+			}
+			break;
+		}
+		case OP_OR:
+		case OP_AND:
+		case OP_XOR: {
+			if (stack.size() < 2)
+				return Error::TooManyOps;
+			Entry b = std::move(stack.back());
+			stack.pop_back();
+			Entry a = std::move(stack.back());
+			stack.pop_back();
+			Entry r;
+			r.isConst = false;
+			r.value = false;
+			if (a.isConst && b.isConst) {
+				r.isConst = true;
+				r.value = op.code == OP_OR	? (a.value || b.value)
+						  : op.code == OP_AND ? (a.value && b.value)
+											  : (a.value != b.value);
+			}
+			else if (a.isConst || b.isConst) {
+				bool c = a.isConst ? a.value : b.value;
+				Entry &sym = a.isConst ? b : a;
+				if (op.code == OP_AND && !c) {
+					r.isConst = true; /* x & 0 == 0; prune the subtree */
+					r.value = false;
+				}
+				else if (op.code == OP_OR && c) {
+					r.isConst = true; /* x | 1 == 1; prune the subtree */
+					r.value = true;
+				}
+				else {
+					r.ops = std::move(sym.ops);
+					if (op.code == OP_XOR && c) {
+						Op n = {}; /* x ^ 1 == !x */
+						n.code = OP_NOT;
+						r.ops.push_back(n);
+					}
 				}
-				a = varstack[vstacki - 1];
-				b = varstack[vstacki - 2];
+			}
+			else {
+				r.ops = std::move(a.ops);
+				r.ops.insert(r.ops.end(), b.ops.begin(), b.ops.end());
+				Op o = {};
+				o.code = op.code;
+				r.ops.push_back(o);
+			}
+			stack.push_back(std::move(r));
+			break;
+		}
+		default:
+			return Error::BadOp;
+		}
+	}
+
+	if (stack.size() != 1)
+		return Error::StackUnderflow;
+	Entry &res = stack.back();
+	if (res.isConst) {
+		Op op = {};
+		op.code = OP_CONST;
+		op.var = res.value ? 1 : 0;
+		res.ops.assign(1, op);
+	}
+	if (res.ops.size() > EXPR_SIZE)
+		return Error::BufTooSmall;
+	std::memcpy(m_ops, res.ops.data(), res.ops.size() * sizeof(Op));
+	m_numOps = (int)res.ops.size();
+	return Error::OK;
+}
+
+/* Evaluates the compiled ops over many assignments without re-touching the RPN string */
+template <std::size_t EXPR_SIZE>
+Error BoolExpression<EXPR_SIZE>::evalMany(const bool *varMatrix, std::size_t stride, bool *results,
+										  std::size_t count) {
+	if (m_numOps == 0) {
+		Error err = compile();
+		if (err != Error::OK)
+			return err;
+	}
+
+	for (std::size_t n = 0; n < count; n++) {
+		const bool *vars = varMatrix + n * stride;
+		bool varstack[EXPR_SIZE];
+		int vstacki = 0;
+		for (int i = 0; i < m_numOps; i++) {
+			const Op &op = m_ops[i];
+			switch (op.code) {
+			case OP_PUSH:
+				varstack[vstacki++] = vars[op.var];
+				break;
+			case OP_CONST:
+				varstack[vstacki++] = op.var != 0;
+				break;
+			case OP_OR:
+				if (vstacki < 2)
+					return Error::TooManyOps;
 				vstacki--;
-				varstack[vstacki] = a || b;
+				varstack[vstacki - 1] = varstack[vstacki - 1] || varstack[vstacki];
 				break;
-			case AND:
-				if (!opCheck(vstacki, 2)) {
+			case OP_AND:
+				if (vstacki < 2)
 					return Error::TooManyOps;
-				}
-				a = varstack[vstacki - 1];
-				b = varstack[vstacki - 2];
 				vstacki--;
-				varstack[vstacki] = a && b;
+				varstack[vstacki - 1] = varstack[vstacki - 1] && varstack[vstacki];
 				break;
-			case COM:
-			case NOT:
-				if (!opCheck(vstacki, 1)) {
+			case OP_NOT:
+				if (vstacki < 1)
 					return Error::TooManyOps;
-				}
-				//vstacki -= 1;
-				varstack[vstacki-1] = !varstack[vstacki-1];
+				varstack[vstacki - 1] = !varstack[vstacki - 1];
 				break;
-			case XOR:
-				if (!opCheck(vstacki, 2)) {
+			case OP_XOR:
+				if (vstacki < 2)
 					return Error::TooManyOps;
-				}
-				a = varstack[vstacki - 1];
-				b = varstack[vstacki - 2];
 				vstacki--;
-				varstack[vstacki] = a ^ b;
+				varstack[vstacki - 1] = varstack[vstacki - 1] ^ varstack[vstacki];
 				break;
 			default:
 				return Error::BadOp;
 			}
 		}
+		if (vstacki <= 0)
+			return Error::StackUnderflow;
+		results[n] = varstack[vstacki - 1];
+	}
+	return Error::OK;
+}
+
+/* Evaluates the compiled ops with one uint64_t lane per assignment */
+template <std::size_t EXPR_SIZE>
+Error BoolExpression<EXPR_SIZE>::evalPacked(const std::uint64_t *varBits, std::uint64_t &resultBits) {
+	if (m_numOps == 0) {
+		Error err = compile();
+		if (err != Error::OK)
+			return err;
 	}
 
-	result = varstack[vstacki];
+	std::uint64_t varstack[EXPR_SIZE];
+	int vstacki = 0;
+	for (int i = 0; i < m_numOps; i++) {
+		const Op &op = m_ops[i];
+		switch (op.code) {
+		case OP_PUSH:
+			varstack[vstacki++] = varBits[op.var];
+			break;
+		case OP_CONST:
+			varstack[vstacki++] = op.var ? ~(std::uint64_t)0 : 0;
+			break;
+		case OP_OR:
+			if (vstacki < 2)
+				return Error::TooManyOps;
+			vstacki--;
+			varstack[vstacki - 1] = varstack[vstacki - 1] | varstack[vstacki];
+			break;
+		case OP_AND:
+			if (vstacki < 2)
+				return Error::TooManyOps;
+			vstacki--;
+			varstack[vstacki - 1] = varstack[vstacki - 1] & varstack[vstacki];
+			break;
+		case OP_NOT:
+			if (vstacki < 1)
+				return Error::TooManyOps;
+			varstack[vstacki - 1] = ~varstack[vstacki - 1];
+			break;
+		case OP_XOR:
+			if (vstacki < 2)
+				return Error::TooManyOps;
+			vstacki--;
+			varstack[vstacki - 1] = varstack[vstacki - 1] ^ varstack[vstacki];
+			break;
+		default:
+			return Error::BadOp;
+		}
+	}
+	if (vstacki <= 0)
+		return Error::StackUnderflow;
+	resultBits = varstack[vstacki - 1];
 	return Error::OK;
 }
 
+/**
+ * Compile-time variant of BoolExpression for string-literal expressions.
+ *
+ * A `static constexpr StaticBoolExpression` is fully lowered to its op array at compile time,
+ * so there is zero startup cost and eval() of a constant mask can fold away entirely. To stay
+ * constexpr-constructible (no dynamic containers, no symbol table), variables use the old
+ * single-char encoding: 'A'..'Z', index = char - 'A'. Malformed expressions surface through
+ * error(), which is static_assert-able.
+ */
+template <std::size_t EXPR_SIZE = 64>
+class StaticBoolExpression {
+public:
+	static constexpr int PARAM_MAX = 'Z' - 'A' + 1;
+
+	enum OpCode : unsigned char {
+		OP_PUSH = 0, // Push variable [var] onto the stack
+		OP_OR,
+		OP_AND,
+		OP_NOT,
+		OP_XOR
+	};
+
+	struct Op {
+		unsigned char code = 0;
+		unsigned char var = 0;
+	};
+
+	constexpr StaticBoolExpression(const char *expr) : m_err(parse(expr)) {
+	}
+
+	constexpr Error error() const {
+		return m_err;
+	}
+	constexpr bool good() const {
+		return m_err == Error::OK;
+	}
+	constexpr int numOps() const {
+		return m_numOps;
+	}
+
+	/**
+	 * @brief Evaluates the expression; bit v of varMask holds variable 'A'+v's value
+	 *
+	 * parse() verifies stack depths up front, so a good() expression cannot underflow here
+	 * and the result is usable in static_assert.
+	 */
+	constexpr bool eval(std::uint32_t varMask) const {
+		bool varstack[EXPR_SIZE] = {};
+		int vstacki = 0;
+		for (int i = 0; i < m_numOps; i++) {
+			const Op &op = m_ops[i];
+			switch (op.code) {
+			case OP_PUSH:
+				varstack[vstacki++] = (varMask >> op.var) & 1;
+				break;
+			case OP_OR:
+				vstacki--;
+				varstack[vstacki - 1] = varstack[vstacki - 1] || varstack[vstacki];
+				break;
+			case OP_AND:
+				vstacki--;
+				varstack[vstacki - 1] = varstack[vstacki - 1] && varstack[vstacki];
+				break;
+			case OP_NOT:
+				varstack[vstacki - 1] = !varstack[vstacki - 1];
+				break;
+			case OP_XOR:
+				vstacki--;
+				varstack[vstacki - 1] = varstack[vstacki - 1] ^ varstack[vstacki];
+				break;
+			}
+		}
+		return vstacki > 0 ? varstack[vstacki - 1] : false;
+	}
+
+private:
+	static constexpr bool isSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+	static constexpr bool isOp(char c) {
+		return c == '|' || c == '&' || c == '~' || c == '!' || c == '^';
+	}
+	static constexpr int precedence(char c) {
+		return ((c == '|' || c == '^') ? 0 : c == '&' ? 1 : 2);
+	}
+	static constexpr bool isVar(char c) {
+		return c >= 'A' && c <= 'Z';
+	}
+	static constexpr int opFromChar(char c) {
+		return c == '|' ? OP_OR : c == '&' ? OP_AND : c == '^' ? OP_XOR : OP_NOT;
+	}
+
+	/* Same shunting yard as BoolExpression::parse, restricted to what C++17 constexpr allows:
+	 * fixed buffers, single-char variables */
+	constexpr Error parse(const char *expr) {
+		char opstack[EXPR_SIZE] = {};
+		int stacki = 0;
+
+		for (const char *s = expr; s && *s; s++) {
+			if (isSpace(*s))
+				continue;
+			if (*s == '(') {
+				opstack[stacki++] = *s;
+				continue;
+			}
+			if (isOp(*s)) {
+				while (stacki > 0 && opstack[stacki - 1] != '(' && precedence(opstack[stacki - 1]) > precedence(*s)) {
+					if (m_numOps >= (int)EXPR_SIZE)
+						return Error::BufTooSmall;
+					m_ops[m_numOps].code = (unsigned char)opFromChar(opstack[stacki - 1]);
+					m_numOps++;
+					stacki--;
+				}
+				opstack[stacki++] = *s;
+				continue;
+			}
+			if (*s == ')') {
+				while (stacki > 0 && opstack[stacki - 1] != '(') {
+					if (m_numOps >= (int)EXPR_SIZE)
+						return Error::BufTooSmall;
+					m_ops[m_numOps].code = (unsigned char)opFromChar(opstack[stacki - 1]);
+					m_numOps++;
+					stacki--;
+				}
+				if (stacki <= 0 || opstack[stacki - 1] != '(')
+					return Error::UnmatchedClosingParenths;
+				stacki--;
+				continue;
+			}
+			if (isVar(*s)) {
+				if (m_numOps >= (int)EXPR_SIZE)
+					return Error::BufTooSmall;
+				m_ops[m_numOps].code = OP_PUSH;
+				m_ops[m_numOps].var = (unsigned char)(*s - 'A');
+				m_numOps++;
+				continue;
+			}
+			return Error::BadToken;
+		}
+		while (stacki > 0) {
+			if (opstack[stacki - 1] == '(')
+				return Error::UnmatchedClosingParenths;
+			if (m_numOps >= (int)EXPR_SIZE)
+				return Error::BufTooSmall;
+			m_ops[m_numOps].code = (unsigned char)opFromChar(opstack[stacki - 1]);
+			m_numOps++;
+			stacki--;
+		}
+
+		/* Verify stack depths so eval() never has to */
+		int depth = 0;
+		for (int i = 0; i < m_numOps; i++) {
+			if (m_ops[i].code == OP_PUSH)
+				depth++;
+			else if (m_ops[i].code == OP_NOT) {
+				if (depth < 1)
+					return Error::StackUnderflow;
+			}
+			else {
+				if (depth < 2)
+					return Error::StackUnderflow;
+				depth--;
+			}
+		}
+		if (depth != 1)
+			return Error::StackUnderflow;
+
+		return Error::OK;
+	}
+
+	Op m_ops[EXPR_SIZE] = {};
+	int m_numOps = 0;
+	Error m_err = Error::OK;
+};
+
+/**
+ * Owns many parsed expressions over one shared symbol table and evaluates them as a batch.
+ *
+ * Rules are hash-consed into a single DAG as they are added: structurally identical
+ * subexpressions (after canonicalizing commutative operand order) map to one node, so a
+ * predicate shared by a thousand rules is evaluated once per assignment instead of a
+ * thousand times. evalAll() walks the DAG level by level, splitting wide levels across a
+ * worker pool; rule results are just reads of their root nodes.
+ *
+ * For event streams where the assignment barely changes between evaluations, set()/eval()
+ * maintain the DAG incrementally: every node caches its value and a variable change only
+ * recomputes the nodes whose inputs actually changed.
+ */
+template <std::size_t EXPR_SIZE = 256>
+class RuleSet {
+	using Expr = BoolExpression<EXPR_SIZE>;
+
+public:
+	/**
+	 * @brief Defines a variable in the shared symbol table; see BoolExpression::define
+	 */
+	int define(const char *varName, bool value = false) {
+		int idx = m_proto.define(varName, value);
+		if (m_incReady && idx >= 0)
+			set(idx, value); /* Redefinition must dirty dependents like any other change */
+		return idx;
+	}
+
+	/**
+	 * @brief Parses an expression and merges it into the shared DAG
+	 * @param expression Infix expression over variables defined on this set
+	 * @param err Receives the parse error, if any
+	 * @return Index of the new rule, or -1 if the expression failed to parse
+	 */
+	int addRule(const char *expression, Error *err = nullptr) {
+		Expr e = m_proto;
+		std::strncpy(e.m_expr, expression, EXPR_SIZE);
+		e.m_expr[EXPR_SIZE - 1] = 0;
+		Error res = e.parse();
+		if (res == Error::OK && e.m_numOps == 0)
+			res = Error::BadToken;
+		if (res != Error::OK) {
+			if (err)
+				*err = res;
+			return -1;
+		}
+
+		int stack[EXPR_SIZE];
+		int si = 0;
+		for (int i = 0; i < e.m_numOps; i++) {
+			const auto &op = e.m_ops[i];
+			switch (op.code) {
+			case Expr::OP_PUSH:
+			case Expr::OP_CONST:
+				stack[si++] = intern(op.code, op.var, -1);
+				break;
+			case Expr::OP_NOT:
+				if (si < 1) {
+					if (err)
+						*err = Error::StackUnderflow;
+					return -1;
+				}
+				stack[si - 1] = intern(op.code, stack[si - 1], -1);
+				break;
+			default:
+				if (si < 2) {
+					if (err)
+						*err = Error::StackUnderflow;
+					return -1;
+				}
+				si--;
+				stack[si - 1] = intern(op.code, stack[si - 1], stack[si]);
+				break;
+			}
+		}
+		if (si != 1) {
+			if (err)
+				*err = Error::StackUnderflow;
+			return -1;
+		}
+
+		if (err)
+			*err = Error::OK;
+		m_totalOps += e.m_numOps;
+		m_roots.push_back(stack[0]);
+		m_incReady = false; /* New nodes; the incremental state reprimes on next eval() */
+		return (int)m_roots.size() - 1;
+	}
+
+	inline std::size_t numRules() const {
+		return m_roots.size();
+	}
+	/* DAG nodes after CSE; compare against totalOps() for the dedup win */
+	inline std::size_t numNodes() const {
+		return m_nodes.size();
+	}
+	inline int totalOps() const {
+		return m_totalOps;
+	}
+
+	/**
+	 * @brief Evaluates every rule against one variable assignment
+	 * @param vars Value per variable index; must cover every variable used by the rules
+	 * @param out Receives one result per rule, indexed by addRule order
+	 * @param threads Worker count; 0 picks the hardware concurrency. Levels narrower than
+	 * the split threshold run serially regardless
+	 * @return Error
+	 */
+	Error evalAll(const bool *vars, std::vector<bool> &out, int threads = 0) {
+		if (threads <= 0)
+			threads = (int)std::thread::hardware_concurrency();
+
+		std::vector<unsigned char> values(m_nodes.size());
+
+		auto evalRange = [&](const std::vector<int> &level, std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; i++) {
+				const Node &n = m_nodes[level[i]];
+				unsigned char v = 0;
+				switch (n.code) {
+				case Expr::OP_PUSH:
+					v = vars[n.lhs];
+					break;
+				case Expr::OP_CONST:
+					v = n.lhs != 0;
+					break;
+				case Expr::OP_OR:
+					v = values[n.lhs] | values[n.rhs];
+					break;
+				case Expr::OP_AND:
+					v = values[n.lhs] & values[n.rhs];
+					break;
+				case Expr::OP_NOT:
+					v = !values[n.lhs];
+					break;
+				case Expr::OP_XOR:
+					v = values[n.lhs] ^ values[n.rhs];
+					break;
+				}
+				values[level[i]] = v;
+			}
+		};
+
+		/* Nodes within a level are independent; levels themselves are ordered. Only bother
+		 * spinning up workers when a level is wide enough to pay for the spawns */
+		constexpr std::size_t PARALLEL_THRESHOLD = 512;
+		for (const auto &level : m_levels) {
+			if (threads <= 1 || level.size() < PARALLEL_THRESHOLD) {
+				evalRange(level, 0, level.size());
+				continue;
+			}
+			std::vector<std::thread> pool;
+			std::size_t chunk = (level.size() + threads - 1) / threads;
+			for (int t = 0; t < threads; t++) {
+				std::size_t b = (std::size_t)t * chunk;
+				if (b >= level.size())
+					break;
+				std::size_t e = b + chunk < level.size() ? b + chunk : level.size();
+				pool.emplace_back(evalRange, std::cref(level), b, e);
+			}
+			for (auto &th : pool)
+				th.join();
+		}
+
+		out.resize(m_roots.size());
+		for (std::size_t r = 0; r < m_roots.size(); r++)
+			out[r] = values[m_roots[r]] != 0;
+		return Error::OK;
+	}
+
+	/**
+	 * @brief Sets a variable's value, dirtying only the DAG nodes that depend on it
+	 *
+	 * Between telemetry events typically one or two flags change, so rather than re-running
+	 * every rule, set() updates the variable's leaf node and marks the nodes reachable from
+	 * it dirty. The next eval() recomputes dirty nodes bottom-up and stops propagating
+	 * wherever a recomputed value comes out unchanged — an AND already forced low by its
+	 * other operand absorbs the change on the spot — so a flag flip costs a handful of node
+	 * updates no matter how many rules share the DAG. Values passed to define() seed the
+	 * assignment. Setting a variable no rule reads is a no-op.
+	 */
+	void set(int varIndex, bool value) {
+		m_proto.set(varIndex, value);
+		if (!m_incReady)
+			return; /* The first eval() computes everything from the variable values anyway */
+		if (varIndex >= (int)m_varNode.size() || m_varNode[varIndex] < 0)
+			return;
+		int leaf = m_varNode[varIndex];
+		if (m_values[leaf] == (unsigned char)(value ? 1 : 0))
+			return;
+		m_values[leaf] = value ? 1 : 0;
+		for (int p : m_parents[leaf])
+			markDirty(p);
+	}
+
+	/**
+	 * @brief Result of one rule under the variables given to define()/set()
+	 *
+	 * The first call evaluates the whole DAG and builds the reverse edges; every call after
+	 * that only flushes the nodes dirtied by set() since the last eval.
+	 * @param rule Rule index as returned by addRule
+	 */
+	bool eval(int rule) {
+		assert(rule >= 0 && rule < (int)m_roots.size());
+		flush();
+		return m_values[m_roots[rule]] != 0;
+	}
+
+private:
+	struct Node {
+		unsigned char code;
+		int lhs; /* Variable index for OP_PUSH, 0/1 for OP_CONST, child node otherwise */
+		int rhs; /* Second child for binary ops, -1 otherwise */
+		int depth;
+	};
+
+	/* Value numbering: returns the existing node for (code, lhs, rhs) or appends a new one */
+	int intern(unsigned char code, int lhs, int rhs) {
+		if (rhs >= 0 && lhs > rhs) { /* All binary ops here are commutative */
+			int tmp = lhs;
+			lhs = rhs;
+			rhs = tmp;
+		}
+		std::uint64_t key = ((std::uint64_t)code << 56) | (((std::uint64_t)(lhs + 1) & 0xFFFFFFF) << 28) |
+							((std::uint64_t)(rhs + 1) & 0xFFFFFFF);
+		auto it = m_nodeMap.find(key);
+		if (it != m_nodeMap.end())
+			return it->second;
+
+		Node n;
+		n.code = code;
+		n.lhs = lhs;
+		n.rhs = rhs;
+		if (code == Expr::OP_PUSH || code == Expr::OP_CONST)
+			n.depth = 0;
+		else if (rhs < 0)
+			n.depth = m_nodes[lhs].depth + 1;
+		else
+			n.depth = (m_nodes[lhs].depth > m_nodes[rhs].depth ? m_nodes[lhs].depth : m_nodes[rhs].depth) + 1;
+
+		int id = (int)m_nodes.size();
+		m_nodes.push_back(n);
+		if ((int)m_levels.size() <= n.depth)
+			m_levels.resize(n.depth + 1);
+		m_levels[n.depth].push_back(id);
+		m_nodeMap.emplace(key, id);
+		return id;
+	}
+
+	/* Incremental evaluation. One value per node plus reverse edges, built on the first
+	 * eval() and torn down whenever a rule is added */
+	void prime() {
+		m_parents.assign(m_nodes.size(), {});
+		m_varNode.assign(m_proto.numVars(), -1);
+		m_values.assign(m_nodes.size(), 0);
+		m_dirty.assign(m_nodes.size(), false);
+		m_dirtyLevels.assign(m_levels.size(), {});
+		for (int id = 0; id < (int)m_nodes.size(); id++) {
+			const Node &n = m_nodes[id];
+			if (n.code == Expr::OP_PUSH) {
+				m_varNode[n.lhs] = id;
+				continue;
+			}
+			if (n.code == Expr::OP_CONST)
+				continue;
+			m_parents[n.lhs].push_back(id);
+			if (n.rhs >= 0 && n.rhs != n.lhs)
+				m_parents[n.rhs].push_back(id);
+		}
+		for (const auto &level : m_levels)
+			for (int id : level)
+				m_values[id] = compute(id);
+		m_incReady = true;
+	}
+
+	unsigned char compute(int id) const {
+		const Node &n = m_nodes[id];
+		switch (n.code) {
+		case Expr::OP_PUSH:
+			return m_proto.m_varVals[n.lhs];
+		case Expr::OP_CONST:
+			return n.lhs != 0;
+		case Expr::OP_OR:
+			return m_values[n.lhs] | m_values[n.rhs];
+		case Expr::OP_AND:
+			return m_values[n.lhs] & m_values[n.rhs];
+		case Expr::OP_NOT:
+			return !m_values[n.lhs];
+		case Expr::OP_XOR:
+			return m_values[n.lhs] ^ m_values[n.rhs];
+		}
+		return 0;
+	}
+
+	void markDirty(int id) {
+		if (m_dirty[id])
+			return;
+		m_dirty[id] = true;
+		m_dirtyLevels[m_nodes[id].depth].push_back(id);
+	}
+
+	void flush() {
+		if (!m_incReady) {
+			prime();
+			return;
+		}
+		/* Depth order settles children before parents; an unchanged recomputed value ends
+		 * the propagation right there. Parents always sit at a strictly greater depth, so
+		 * markDirty never appends to a level already being drained */
+		for (auto &level : m_dirtyLevels) {
+			for (std::size_t i = 0; i < level.size(); i++) {
+				int id = level[i];
+				m_dirty[id] = false;
+				unsigned char v = compute(id);
+				if (v == m_values[id])
+					continue;
+				m_values[id] = v;
+				for (int p : m_parents[id])
+					markDirty(p);
+			}
+			level.clear();
+		}
+	}
+
+	Expr m_proto { "" }; /* Holds the shared symbol table; copied per rule for parsing */
+	std::vector<Node> m_nodes;
+	std::vector<int> m_roots; /* One root node per rule */
+	std::vector<std::vector<int>> m_levels;
+	std::unordered_map<std::uint64_t, int> m_nodeMap;
+	int m_totalOps = 0;
+
+	bool m_incReady = false;
+	std::vector<unsigned char> m_values;		 /* Cached value per node */
+	std::vector<std::vector<int>> m_parents;	 /* Reverse edges: node -> nodes reading it */
+	std::vector<int> m_varNode;					 /* Variable index -> its OP_PUSH node, or -1 */
+	std::vector<bool> m_dirty;
+	std::vector<std::vector<int>> m_dirtyLevels; /* Dirty worklist bucketed by node depth */
+};
+
 } // namespace expr
\ No newline at end of file
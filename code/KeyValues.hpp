@@ -47,6 +47,35 @@ For more information, please refer to <http://unlicense.org/>
 #include <cctype>
 #include <stack>
 #include <cerrno>
+#include <climits>
+#include <new>
+#include <cstdint>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* LoadFiles drives its read stage through io_uring where available, so dozens of reads are
+ * in flight while parse workers chew on buffers that have already arrived. Define
+ * KEYVALUES_NO_IOURING to force the threaded read fallback; the fallback is also taken at
+ * runtime when the kernel refuses the ring (old kernel, seccomp, etc.) */
+#ifndef KEYVALUES_NO_IOURING
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define KEYVALUES_HAS_IOURING 1
+#endif
+#endif
+#endif
 
 class KeyValues {
 public:
@@ -55,6 +84,92 @@ public:
 	typedef void *(*KeyValuesMalloc_t)(size_t);
 	typedef void (*KeyValuesFree_t)(void *);
 
+	enum class EError {
+		NONE = 0,
+		UNEXPECTED_EOF,
+		MISSING_BRACKET,
+		MISSING_QUOTE,
+		UNNAMED_SECTION,
+		UNTERMINATED_SECTION,
+	};
+
+	typedef void (*pfnErrorCallback_t)(int, int, EError);
+
+	/**
+	 * Simple bump allocator. When passed to FromFile/FromString, all key strings, value strings
+	 * and child KeyValues nodes are carved out of large contiguous blocks owned by the arena,
+	 * instead of being individually malloc'd. The entire tree's memory is released in one shot
+	 * when the arena is destroyed (or Reset). The arena must outlive the tree; delete the root
+	 * node before destroying the arena.
+	 */
+	class Arena {
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+		explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+		~Arena();
+
+		Arena(const Arena &) = delete;
+		Arena &operator=(const Arena &) = delete;
+
+		/* Carve sz bytes out of the current block, chaining a new block if needed */
+		void *Alloc(size_t sz);
+
+		/* Release every block at once */
+		void Reset();
+
+	private:
+		struct Block {
+			Block *next;
+			size_t used;
+			size_t size;
+			/* Data follows the header */
+		};
+
+		Block *NewBlock(size_t sz);
+
+		Block *m_blocks;
+		size_t m_blockSize;
+	};
+
+	/**
+	 * String interning pool, shareable across any number of trees. When attached to a parse
+	 * (SetInternPool or the FromFile/FromString overloads below), identical key strings
+	 * share one allocation in the pool and each Key carries a 32-bit interned id, letting
+	 * lookups compare ids instead of calling strcmp. The pool must outlive every tree using
+	 * it. Not thread-safe: parses sharing one pool must be serialized (or keys pre-interned).
+	 */
+	class InternPool {
+	public:
+		InternPool() = default;
+
+		InternPool(const InternPool &) = delete;
+		InternPool &operator=(const InternPool &) = delete;
+
+		/* Returns the id for s, interning it if new. Ids start at 1 */
+		uint32_t Intern(const char *s);
+
+		/* Returns the id if s is already interned, 0 otherwise */
+		uint32_t Find(const char *s) const;
+
+		/* Returns the pooled string for a valid id */
+		const char *String(uint32_t id) const {
+			return m_strings[id - 1];
+		}
+
+		size_t Size() const {
+			return m_strings.size();
+		}
+
+	private:
+		void Grow();
+
+		Arena m_arena; /* Backing storage for the pooled strings */
+		std::vector<const char *> m_strings;
+		std::vector<uint32_t> m_hashes;
+		std::vector<int32_t> m_table; /* Open addressing, -1 for vacant */
+	};
+
 	class Key {
 	public:
 		char *key;
@@ -74,13 +189,32 @@ public:
 
 		bool quoted;
 
+		/* Id of the interned key string, or 0 if the key is not pooled. Pooled key
+		 * strings are owned by the InternPool, not this node */
+		uint32_t keyId;
+
+		/* Set when a mutator installed a heap-allocated value on an in-situ node. In-situ
+		 * strings live in the shared source buffer and are never individually freed, but a
+		 * replacement value is this key's to release */
+		bool ownedValue;
+
 		Key() {
+			key = value = nullptr;
 			cached = ELastCached::NONE;
+			quoted = false;
+			keyId = 0;
+			ownedValue = false;
 		};
 
 		inline bool ReadBool(bool &ok);
 		inline long int ReadInt(bool &ok);
 		inline double ReadFloat(bool &ok);
+
+		/* Non-mutating mirrors of the above, used on frozen trees: serve the cache when it
+		 * matches, otherwise parse locally without writing the cache back */
+		inline bool PeekBool(bool &ok) const;
+		inline long int PeekInt(bool &ok) const;
+		inline double PeekFloat(bool &ok) const;
 	};
 
 public:
@@ -109,15 +243,128 @@ public:
 
 	bool HasKey(const char *key);
 
+	/**
+	 * @brief Resolves a slash-separated path ("weapons/rifle/damage") to a key.
+	 *
+	 * Intermediate segments name child sections, the final segment names a key. Resolved
+	 * paths are cached on the node this is called on, so a repeated deep lookup is one
+	 * hash probe plus the final key lookup instead of a GetChild chain. Value changes
+	 * don't stale the cache (the key is re-resolved every call); re-parsing this node
+	 * drops it.
+	 * @return The key, or nullptr if any segment is missing
+	 */
+	Key *GetByPath(const char *path);
+
+	/* Typed conveniences over GetByPath */
+	int GetIntByPath(const char *path, int _default = -1);
+	bool GetBoolByPath(const char *path, bool _default = false);
+	double GetDoubleByPath(const char *path, double _default = 0.0);
+	const char *GetStringByPath(const char *path, const char *_default = nullptr);
+
 	/* Setters */
 	void SetBool(const char *key, bool v);
 	void SetInt(const char *key, int v);
 	void SetFloat(const char *key, float v);
 	void SetString(const char *key, const char *v);
 
+	/**
+	 * Like SetString, but adopts `v` instead of copying it, so a caller that already
+	 * formatted the value into a heap buffer hands it over with zero extra allocation.
+	 * The buffer must have been allocated compatibly with this tree's free path (plain
+	 * malloc unless a custom allocator is set; never hand buffers to an arena-backed
+	 * tree). If the key does not exist the buffer is freed, matching SetString's
+	 * ignore-missing behavior without leaking.
+	 */
+	void SetStringOwned(const char *key, char *v);
+
+	/* Appends a new key with the given value; both strings are copied. Unlike SetString,
+	 * no existing key is looked up, so bulk tree construction is pure appends */
+	Key &AddKey(const char *key, const char *value);
+
+	/* Appends a new key, adopting both heap buffers instead of copying them. Same
+	 * allocation contract as SetStringOwned */
+	Key &AddKeyOwned(char *key, char *value);
+
+	/* Appends and returns a new empty child section */
+	KeyValues *AddChild(const char *name);
+
+	/* Preallocates key (and optionally child section) capacity, so appending a known
+	 * number of keys doesn't regrow the storage through repeated doublings */
+	void Reserve(size_t numKeys, size_t numChildren = 0);
+
+	/* Parse behavior flags; pass to FromFile/FromString or set with SetParseOptions
+	 * before an instance parse */
+	enum ParseOptions : unsigned {
+		EAGER_NUMERIC = 1 << 0, /* Fill the numeric value caches during parse, in bulk */
+	};
+
+	inline void SetParseOptions(unsigned options) {
+		m_parseOptions = options;
+	}
+
+	/**
+	 * @brief Converts every numeric or boolean value in this tree into its cache slot now.
+	 *
+	 * Does in one pass what lazy ReadInt/ReadFloat/ReadBool calls would do one value at a
+	 * time on first access — predictable load-time cost instead of first-use spikes.
+	 * Values that parse as neither are left for GetString.
+	 */
+	void PrecacheValues();
+
+	/**
+	 * @brief Makes this tree safe for lock-free concurrent readers.
+	 *
+	 * The getters are read-mostly but not read-only: the lazy numeric cache, lazy index
+	 * builds and the path cache all write on first access, so unsynchronized readers race
+	 * on a shared tree. Freeze() front-loads all of that work — numeric caches, key hashes
+	 * and lookup indexes for the whole subtree — then flips the tree into a mode where
+	 * every getter is strictly non-mutating, so any number of threads may read it
+	 * concurrently with no locking. The tree must be treated as immutable afterwards:
+	 * calling a setter or re-parsing a frozen tree is a data race like any other
+	 * unsynchronized write.
+	 */
+	void Freeze();
+
+	bool Frozen() const {
+		return m_frozen;
+	}
+
 	/* Parse from a file */
-	static KeyValues* FromFile(const char* file, bool use_escape_codes = false);
-	static KeyValues* FromString(const char* string, bool use_escape_codes = false);
+	static KeyValues* FromFile(const char* file, bool use_escape_codes = false, unsigned options = 0);
+	static KeyValues* FromString(const char* string, bool use_escape_codes = false, unsigned options = 0);
+
+	/* Parse with all tree memory carved out of the given arena */
+	static KeyValues* FromFile(const char* file, Arena& arena, bool use_escape_codes = false);
+	static KeyValues* FromString(const char* string, Arena& arena, bool use_escape_codes = false);
+
+	/* Parse with key strings deduplicated through a shared interning pool */
+	static KeyValues* FromFile(const char* file, InternPool& pool, bool use_escape_codes = false);
+	static KeyValues* FromString(const char* string, InternPool& pool, bool use_escape_codes = false);
+
+	/* Attach an interning pool consulted by subsequent Parse* calls on this tree */
+	void SetInternPool(InternPool* pool);
+
+	/**
+	 * Parse in-situ: key and value strings point directly into `data` with terminators patched
+	 * in place, so unquoted/unescaped tokens incur zero copies and zero allocations. The buffer
+	 * is modified and must outlive the tree. With take_ownership the tree frees the buffer
+	 * (with free()) on destruction. Trees parsed this way are read-mostly; SetString still works
+	 * and allocates a fresh copy for the new value, which the tree releases on destruction.
+	 */
+	static KeyValues* FromBuffer(char* data, size_t len, bool take_ownership = false, bool use_escape_codes = false);
+	bool ParseBuffer(char* data, size_t len, bool take_ownership = false, bool use_escape_codes = false);
+
+	/**
+	 * Reads and parses many independent files, overlapping I/O with parsing: a read stage
+	 * keeps a window of reads in flight (io_uring on Linux, a pool of blocking readers
+	 * elsewhere) while parse workers consume buffers as they arrive, so cold-cache or
+	 * network-filesystem latency hides behind parse time instead of serializing in front of
+	 * it. Results come back in input order, with nullptr in the slot of any file that failed
+	 * to open, read or parse. Each tree is fully independent, so this is safe to fan out.
+	 * numThreads <= 0 uses one parse worker per hardware core.
+	 */
+	static std::vector<KeyValues *> LoadFiles(const char *const *paths, size_t numFiles, int numThreads = 0,
+											  bool use_escape_codes = false);
 	bool ParseFile(const char *file, bool use_escape_codes = false);
 	bool ParseString(const char *string, bool use_escape_codes = false, long long len = -1);
 
@@ -127,22 +374,248 @@ public:
 	/* Completely removes a key */
 	void RemoveKey(const char *key);
 
+	/**
+	 * Recursively merges an overlay tree into this one: overlay keys replace same-named keys
+	 * here (or are appended), overlay sections merge into same-named sections (or are deep
+	 * copied in). One linear pass over the overlay; lookups on this side go through the hash
+	 * index, so layering a config is O(overlay) instead of O(base * overlay).
+	 */
+	void MergeFrom(const KeyValues &overlay);
+
+	/**
+	 * Produces the minimal patch tree that, merged into this tree with MergeFrom, yields
+	 * `newer`: only added or changed keys and the sections containing them are emitted.
+	 * Key removals are not representable in the overlay model and are ignored. The caller
+	 * owns the returned tree, which may be empty if nothing differs.
+	 */
+	KeyValues *Diff(const KeyValues &newer) const;
+
+	/**
+	 * @brief Duplicates this subtree with a single allocation for all of its strings.
+	 *
+	 * Every name, key and value is measured up front and copied into one bulk block owned
+	 * by the returned root — the same ownership scheme as an in-situ parse — so cloning
+	 * costs one allocation plus one memcpy pass per node instead of a malloc per string,
+	 * and instead of re-parsing source text per consumer. Numeric caches carry over;
+	 * pooled key strings stay shared with the InternPool rather than being copied.
+	 */
+	KeyValues *Clone() const;
+
 	/* Dumps this to stdout */
 	void DumpToStream(FILE *fs);
 
-	enum class EError {
-		NONE = 0,
-		UNEXPECTED_EOF,
-		MISSING_BRACKET,
-		MISSING_QUOTE,
-		UNNAMED_SECTION,
-		UNTERMINATED_SECTION,
+	/**
+	 * Serializes the tree into a growable buffer with plain byte appends - no per-key
+	 * fprintf, no format-string parsing, no stdio lock. Produces byte-identical output to
+	 * DumpToStream; do one fwrite of the result when writing a file. Appends to whatever
+	 * `out` already holds.
+	 */
+	void DumpToBuffer(std::string &out) const;
+
+	/**
+	 * Streaming parser: feed the document in arbitrary chunks (from a pipe, socket, or
+	 * fixed-size read buffer) and the tokenizer state is carried across chunk boundaries,
+	 * so memory stays bounded no matter how large the input is. Call Feed() for each chunk
+	 * and Finish() once at the end to validate and take ownership of the tree. Tokens are
+	 * always copied out of the chunk, so chunk buffers may be reused immediately. Like
+	 * ParseString, input should end with a newline or the trailing token is dropped.
+	 */
+	class Parser {
+	public:
+		explicit Parser(bool use_escape_codes = false, Arena *arena = nullptr);
+		~Parser();
+
+		Parser(const Parser &) = delete;
+		Parser &operator=(const Parser &) = delete;
+
+		/* Consumes one chunk. Returns false once a parse error has been hit */
+		bool Feed(const char *chunk, size_t len);
+
+		/* Finalizes the parse and hands the tree to the caller, or nullptr on error.
+		 * The parser may not be fed again afterwards */
+		KeyValues *Finish();
+
+		bool Good() const {
+			return m_root && m_root->good;
+		}
+
+		void SetErrorCallback(pfnErrorCallback_t callback);
+
+	private:
+		bool ProcessChar(char c, char nc);
+		void SaveToken(bool quotedTok);
+
+		KeyValues *m_root;
+		KeyValues *m_stack[512];
+		int m_stackpos;
+		Key m_curKey;
+		char m_buf[512];
+		int m_bufpos;
+		int m_nline, m_nchar, m_bracketLevel;
+		bool m_inquote, m_incomment, m_parsedKey;
+		/* One byte of lookahead carried between chunks for comment detection */
+		char m_pending, m_prevChar;
+		bool m_hasPending;
 	};
 
-	typedef void (*pfnErrorCallback_t)(int, int, EError);
+	/**
+	 * Writes the tree out in the compiled binary format: a deduplicated string table plus
+	 * flat node/key records with precomputed name hashes and eagerly-converted numeric
+	 * values. Load the result with KeyValues::Compiled, which memory-maps the file and
+	 * serves reads straight out of the map with no parsing and no per-node allocation.
+	 * The format uses native endianness and is not meant for cross-architecture exchange.
+	 */
+	bool CompileToFile(const char *file);
+
+	/* Compiled binary format details */
+	static constexpr uint32_t COMPILED_MAGIC = 0x31425648; /* 'HVB1' */
+	static constexpr uint32_t COMPILED_VERSION = 1;
+
+	struct CompiledHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numNodes;
+		uint32_t numKeys;
+		uint32_t strTabOffset;
+		uint32_t strTabSize;
+	};
+
+	struct CompiledNode {
+		uint32_t name; /* String table offset; 0 is always the empty string */
+		uint32_t nameHash;
+		uint32_t firstKey;
+		uint32_t numKeys;
+		uint32_t firstChild; /* Children of one node are contiguous */
+		uint32_t numChildren;
+	};
+
+	struct CompiledKey {
+		uint32_t key;
+		uint32_t value;
+		uint32_t keyHash;
+		uint8_t cached; /* Key::ELastCached */
+		uint8_t quoted;
+		uint16_t _pad;
+		union {
+			long int ival;
+			double fval;
+			bool bval;
+		} cachedv;
+	};
+
+	/**
+	 * Memory-mapped view of a file written by CompileToFile. The whole tree is served
+	 * directly out of the mapping: no parsing, no per-node allocation. Nodes are exposed
+	 * through the lightweight Compiled::View cursor rather than as KeyValues objects.
+	 */
+	class Compiled {
+	public:
+		class View {
+		public:
+			View() : m_owner(nullptr), m_node(nullptr) {
+			}
+
+			bool Valid() const {
+				return m_node != nullptr;
+			}
+
+			const char *Name() const;
+
+			bool GetBool(const char *key, bool _default = false) const;
+			int GetInt(const char *key, int _default = -1) const;
+			float GetFloat(const char *key, float _default = 0.0f) const;
+			double GetDouble(const char *key, double _default = 0.0) const;
+			const char *GetString(const char *key, const char *_default = nullptr) const;
+			bool HasKey(const char *key) const;
+			View GetChild(const char *name) const;
+
+			uint32_t NumKeys() const;
+			uint32_t NumChildren() const;
+			View Child(uint32_t idx) const;
+
+		private:
+			friend class Compiled;
+			View(const Compiled *owner, const CompiledNode *node) : m_owner(owner), m_node(node) {
+			}
+
+			const CompiledKey *FindKey(const char *key) const;
+
+			const Compiled *m_owner;
+			const CompiledNode *m_node;
+		};
+
+		Compiled();
+		~Compiled();
+
+		Compiled(const Compiled &) = delete;
+		Compiled &operator=(const Compiled &) = delete;
+
+		/* Maps the file and validates the header. Returns false on any mismatch */
+		bool Load(const char *file);
+
+		bool Good() const {
+			return m_header != nullptr;
+		}
+
+		View Root() const;
+
+	private:
+		friend class View;
+
+		const char *String(uint32_t offset) const {
+			return m_strTab + offset;
+		}
+
+		const CompiledHeader *m_header;
+		const CompiledNode *m_nodes;
+		const CompiledKey *m_keys;
+		const char *m_strTab;
+		void *m_map;
+		size_t m_mapSize;
+		bool m_mapped; /* mmap'd rather than malloc'd fallback */
+	};
+
+	/**
+	 * Builds an open-addressing hash index over this section's keys and child sections so
+	 * repeated lookups are O(1) instead of a linear strcmp scan. The index is also built
+	 * lazily on first lookup once a section grows past a small threshold, so calling this
+	 * is only needed to front-load the cost. Iteration order of Keys()/SubKeys() is
+	 * unaffected. Pass recursive=true to index the whole subtree.
+	 */
+	void BuildIndex(bool recursive = false);
 
 	void SetErrorCallback(pfnErrorCallback_t callback);
 
+	/**
+	 * Lightweight cursor over one section: iterates keys and child sections by pointer,
+	 * without copying the 40-byte Key struct the way a by-value range-for does.
+	 */
+	class Cursor {
+	public:
+		explicit Cursor(const KeyValues *kv) : m_kv(kv) {
+		}
+
+		/* Returns the next key, or null when exhausted */
+		const Key *NextKey() {
+			return m_key < m_kv->keys.size() ? &m_kv->keys[m_key++] : nullptr;
+		}
+
+		/* Returns the next child section, or null when exhausted */
+		KeyValues *NextChild() {
+			return m_child < m_kv->child_sections.size() ? m_kv->child_sections[m_child++] : nullptr;
+		}
+
+		void Reset() {
+			m_key = 0;
+			m_child = 0;
+		}
+
+	private:
+		const KeyValues *m_kv;
+		size_t m_key = 0;
+		size_t m_child = 0;
+	};
+
 	// Returns list of all normal keys
 	const std::vector<Key> &Keys() const {
 		return keys;
@@ -158,6 +631,7 @@ private:
 	pfnErrorCallback_t pCallback;
 	
 	void DumpToStreamInternal(FILE *fs, int indent);
+	void DumpToBufferInternal(std::string &out, int indent) const;
 	
 	static inline bool _internal_isspace(char c) {
 		return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
@@ -172,14 +646,310 @@ private:
 	
 	KeyValuesFree_t m_free;
 	KeyValuesMalloc_t m_malloc;
+	Arena *m_arena;
+	InternPool *m_pool;
+	bool m_insitu;	 /* Strings point into m_buffer; do not free them individually */
+	char *m_buffer;	 /* In-situ source buffer, owned by the root node (may be null) */
+	unsigned m_parseOptions; /* ParseOptions flags applied by ParseStringInternal */
+	bool m_frozen;			 /* Getters are strictly non-mutating; see Freeze() */
+
+	struct PathEntry {
+		KeyValues *node;  /* Section holding the final segment */
+		uint32_t keyPos;  /* Offset of the final segment within the path string */
+	};
+	std::unordered_map<std::string, PathEntry> m_pathCache;
+
+	bool ParseStringInternal(char *string, size_t nlen, bool escape, bool insitu);
+
+	/* Sections smaller than this are cheaper to scan linearly than to index */
+	static constexpr size_t INDEX_BUILD_THRESHOLD = 16;
+
+	/* Open-addressing hash indexes mapping key/section-name hash to vector slot.
+	 * Empty when not built; entries are -1 for vacant slots */
+	std::vector<int32_t> m_keyIndex;
+	std::vector<int32_t> m_childIndex;
+
+	/* Structure-of-arrays companion to `keys`: precomputed name hashes, kept in slot order.
+	 * Linear lookups scan this packed array first and only touch the fat Key structs on a
+	 * hash hit, so a miss reads 4 bytes per key instead of dragging the whole 40+ byte
+	 * struct (value pointer, cached union, flags) through the cache. Rebuilt lazily
+	 * whenever it falls out of step with `keys` */
+	std::vector<uint32_t> m_keyHashes;
+	void RefreshKeyHashes();
+
+	static uint32_t HashString(const char *s);
+	void IndexInsert(std::vector<int32_t> &index, bool children, int32_t value);
+	int32_t IndexLookup(const std::vector<int32_t> &index, bool children, const char *name) const;
+	Key *FindKey(const char *key);
+
+	/* Appends a key/child while keeping any built index and the hash array in step.
+	 * The owned variant adopts the key buffer rather than duplicating it */
+	Key &AppendKeyInternal(const char *key);
+	Key &AppendKeyOwnedInternal(char *key);
+	void AppendChildInternal(KeyValues *child);
+
+	KeyValues *DeepCopy() const;
+
+	/* Recursive part of Freeze(); PrecacheValues handles its own recursion */
+	void FreezeInternal();
+
+	/* Clone() internals: string byte count for the bulk block, then the copy pass */
+	size_t CloneStringBytes() const;
+	void CloneInto(KeyValues *dst, char *&cursor) const;
 
 	void *kvmalloc(size_t sz) const;
 	void kvfree(void *ptr) const;
 	char *kvstrdup(const char *s) const;
+
+	/* Allocates a child section, placement-new'ing it into the arena if we have one */
+	KeyValues *NewChild(const char *name);
 };
 
 #ifdef KEYVALUES_IMPLEMENTATION
 
+/* Vectorized scanning kernels for the tokenizer. SSE2 is baseline on x86-64 and NEON on
+ * AArch64, so selection happens at compile time; everything falls back to the scalar loops
+ * below on other targets. Define KEYVALUES_NO_SIMD to force the scalar paths */
+#ifndef KEYVALUES_NO_SIMD
+#if defined(__SSE2__) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KEYVALUES_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define KEYVALUES_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+#ifdef KEYVALUES_SIMD_SSE2
+static inline int kv_ctz(unsigned mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return (int)idx;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/* Returns the first index in [i, end) holding '"' or '\n', or end */
+static size_t kv_find_quote_or_nl(const char *s, size_t i, size_t end) {
+#ifdef KEYVALUES_SIMD_SSE2
+	const __m128i q = _mm_set1_epi8('"');
+	const __m128i nl = _mm_set1_epi8('\n');
+	for (; i + 16 <= end; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, nl)));
+		if (mask)
+			return i + kv_ctz(mask);
+	}
+#elif defined(KEYVALUES_SIMD_NEON)
+	const uint8x16_t q = vdupq_n_u8('"');
+	const uint8x16_t nl = vdupq_n_u8('\n');
+	for (; i + 16 <= end; i += 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)(s + i));
+		uint8x16_t m = vorrq_u8(vceqq_u8(v, q), vceqq_u8(v, nl));
+		if (vmaxvq_u8(m))
+			break; /* Hit somewhere in this block; pinpoint it below */
+	}
+#endif
+	for (; i < end && s[i] != '"' && s[i] != '\n'; i++)
+		;
+	return i;
+}
+
+/* Returns the first index in [i, end) that is not space/tab/newline/CR, or end */
+static size_t kv_skip_ws(const char *s, size_t i, size_t end) {
+#ifdef KEYVALUES_SIMD_SSE2
+	const __m128i sp = _mm_set1_epi8(' ');
+	const __m128i tb = _mm_set1_epi8('\t');
+	const __m128i nl = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	for (; i + 16 <= end; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+		__m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tb)),
+								  _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr)));
+		int mask = _mm_movemask_epi8(ws) ^ 0xFFFF;
+		if (mask)
+			return i + kv_ctz(mask);
+	}
+#elif defined(KEYVALUES_SIMD_NEON)
+	const uint8x16_t sp = vdupq_n_u8(' ');
+	const uint8x16_t tb = vdupq_n_u8('\t');
+	const uint8x16_t nl = vdupq_n_u8('\n');
+	const uint8x16_t cr = vdupq_n_u8('\r');
+	for (; i + 16 <= end; i += 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)(s + i));
+		uint8x16_t ws = vorrq_u8(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, tb)),
+								 vorrq_u8(vceqq_u8(v, nl), vceqq_u8(v, cr)));
+		if (vminvq_u8(ws) == 0)
+			break;
+	}
+#endif
+	for (; i < end && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r'); i++)
+		;
+	return i;
+}
+
+/* Returns the first index in [i, end) holding a delimiter the tokenizer must look at
+ * (whitespace, quote, braces, or a potential comment slash), or end */
+static size_t kv_find_delim(const char *s, size_t i, size_t end) {
+#ifdef KEYVALUES_SIMD_SSE2
+	const __m128i sp = _mm_set1_epi8(' ');
+	const __m128i tb = _mm_set1_epi8('\t');
+	const __m128i nl = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i q = _mm_set1_epi8('"');
+	const __m128i ob = _mm_set1_epi8('{');
+	const __m128i cb = _mm_set1_epi8('}');
+	const __m128i sl = _mm_set1_epi8('/');
+	for (; i + 16 <= end; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tb)),
+								 _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr)));
+		m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, ob)));
+		m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, cb), _mm_cmpeq_epi8(v, sl)));
+		int mask = _mm_movemask_epi8(m);
+		if (mask)
+			return i + kv_ctz(mask);
+	}
+#elif defined(KEYVALUES_SIMD_NEON)
+	const uint8x16_t sp = vdupq_n_u8(' ');
+	const uint8x16_t tb = vdupq_n_u8('\t');
+	const uint8x16_t nl = vdupq_n_u8('\n');
+	const uint8x16_t cr = vdupq_n_u8('\r');
+	const uint8x16_t q = vdupq_n_u8('"');
+	const uint8x16_t ob = vdupq_n_u8('{');
+	const uint8x16_t cb = vdupq_n_u8('}');
+	const uint8x16_t sl = vdupq_n_u8('/');
+	for (; i + 16 <= end; i += 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)(s + i));
+		uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, tb)),
+								vorrq_u8(vceqq_u8(v, nl), vceqq_u8(v, cr)));
+		m = vorrq_u8(m, vorrq_u8(vceqq_u8(v, q), vceqq_u8(v, ob)));
+		m = vorrq_u8(m, vorrq_u8(vceqq_u8(v, cb), vceqq_u8(v, sl)));
+		if (vmaxvq_u8(m))
+			break;
+	}
+#endif
+	for (; i < end; i++) {
+		char c = s[i];
+		if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '"' || c == '{' || c == '}' || c == '/')
+			break;
+	}
+	return i;
+}
+
+/* Locale-free base-10 parse for the ReadInt cache fill. The whole string must be a number;
+ * unlike strtol there is no errno to (forget to) clear and trailing garbage is an error */
+static bool kv_parse_long(const char *s, long &out) {
+	const char *p = s;
+	bool neg = false;
+	if (*p == '+' || *p == '-') {
+		neg = *p == '-';
+		p++;
+	}
+	if (*p < '0' || *p > '9')
+		return false;
+	unsigned long long acc = 0;
+	int digits = 0;
+	for (; *p >= '0' && *p <= '9'; p++) {
+		acc = acc * 10 + (unsigned)(*p - '0');
+		if (++digits > 19)
+			return false;
+	}
+	if (*p)
+		return false;
+	if (acc > (unsigned long long)LONG_MAX + (neg ? 1ull : 0ull))
+		return false;
+	if (!neg)
+		out = (long)acc;
+	else if (acc == 0)
+		out = 0;
+	else
+		out = -(long)(acc - 1) - 1; /* Avoids overflow negating LONG_MIN's magnitude */
+	return true;
+}
+
+/* Locale-free decimal float parse for the ReadFloat cache fill. Mantissas up to 19 digits
+ * with decimal exponents within +-22 are integer accumulation times an exact power of ten,
+ * which rounds identically to a full parse; everything else falls back to strtod */
+static bool kv_parse_double(const char *s, double &out) {
+	static const double pow10tab[] = { 1e0,	 1e1,  1e2,	 1e3,  1e4,	 1e5,  1e6,	 1e7,
+									   1e8,	 1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+									   1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	const char *p = s;
+	bool neg = false;
+	bool slow = false;
+	if (*p == '+' || *p == '-') {
+		neg = *p == '-';
+		p++;
+	}
+
+	unsigned long long mant = 0;
+	int digits = 0;
+	int frac = 0;
+	bool any = false;
+	for (; *p >= '0' && *p <= '9'; p++) {
+		mant = mant * 10 + (unsigned)(*p - '0');
+		digits++;
+		any = true;
+	}
+	if (*p == '.') {
+		p++;
+		for (; *p >= '0' && *p <= '9'; p++) {
+			mant = mant * 10 + (unsigned)(*p - '0');
+			digits++;
+			frac++;
+			any = true;
+		}
+	}
+	slow = !any || digits > 19; /* inf/nan/hex or more digits than an u64 holds exactly */
+
+	int exp10 = 0;
+	if (!slow && (*p == 'e' || *p == 'E')) {
+		p++;
+		bool eneg = false;
+		if (*p == '+' || *p == '-') {
+			eneg = *p == '-';
+			p++;
+		}
+		if (*p < '0' || *p > '9')
+			return false;
+		for (; *p >= '0' && *p <= '9'; p++) {
+			exp10 = exp10 * 10 + (*p - '0');
+			if (exp10 > 9999) {
+				slow = true;
+				break;
+			}
+		}
+		if (eneg)
+			exp10 = -exp10;
+	}
+
+	if (!slow) {
+		if (*p)
+			return false;
+		exp10 -= frac;
+		if ((mant >> 53) || exp10 < -22 || exp10 > 22)
+			slow = true;
+		else {
+			double d = (double)mant;
+			d = exp10 < 0 ? d / pow10tab[-exp10] : d * pow10tab[exp10];
+			out = neg ? -d : d;
+			return true;
+		}
+	}
+
+	char *end = nullptr;
+	errno = 0;
+	double d = strtod(s, &end);
+	if (end == s || *end || errno == ERANGE)
+		return false;
+	out = d;
+	return true;
+}
+
 KeyValues::KeyValues(const char *name, KeyValuesMalloc_t customMalloc, KeyValuesFree_t customFree)
 	: KeyValues() {
 	m_free = customFree;
@@ -189,33 +959,94 @@ KeyValues::KeyValues(const char *name, KeyValuesMalloc_t customMalloc, KeyValues
 	this->quoted = false;
 }
 
-KeyValues::KeyValues() : pCallback(nullptr), good(true), quoted(false), name(nullptr), m_free(nullptr), m_malloc(nullptr) {
+KeyValues::KeyValues() : pCallback(nullptr), good(true), quoted(false), name(nullptr), m_free(nullptr), m_malloc(nullptr),
+	m_arena(nullptr), m_pool(nullptr), m_insitu(false), m_buffer(nullptr), m_parseOptions(0), m_frozen(false) {
 }
 
 KeyValues::~KeyValues() {
-	if (this->name)
-		kvfree(name);
+	/* In-situ strings live in the shared source buffer; only the root may own (and free) that */
+	if (!m_insitu) {
+		if (this->name)
+			kvfree(name);
+
+		/* Free the keys; pooled key strings belong to the InternPool */
+		for (auto &key : this->keys) {
+			if (key.key && !key.keyId)
+				kvfree(key.key);
+			if (key.value)
+				kvfree(key.value);
+		}
+	}
+	else {
+		/* Mutators may have swapped heap values into an in-situ tree; those are ours */
+		for (auto &key : this->keys) {
+			if (key.ownedValue && key.value)
+				kvfree(key.value);
+		}
+	}
 
-	/* Free the keys */
-	for (auto key : this->keys) {
-		if (key.key)
-			kvfree(key.key);
-		if (key.value)
-			kvfree(key.value);
+	if (m_buffer)
+		free(m_buffer);
+
+	/* Free child sections. Arena-backed children were placement-new'd, so only run their
+	 * destructors; their storage belongs to the arena */
+	for (auto section : this->child_sections) {
+		if (section->m_arena)
+			section->~KeyValues();
+		else
+			delete section;
 	}
+}
 
-	/* Free child sections */
-	for (auto section : this->child_sections)
-		delete section;
+KeyValues::Arena::Arena(size_t blockSize) : m_blocks(nullptr), m_blockSize(blockSize) {
+}
+
+KeyValues::Arena::~Arena() {
+	Reset();
+}
+
+KeyValues::Arena::Block *KeyValues::Arena::NewBlock(size_t sz) {
+	auto *block = static_cast<Block *>(malloc(sizeof(Block) + sz));
+	block->next = m_blocks;
+	block->used = 0;
+	block->size = sz;
+	m_blocks = block;
+	return block;
+}
+
+void *KeyValues::Arena::Alloc(size_t sz) {
+	/* Keep everything pointer-aligned */
+	sz = (sz + (sizeof(void *) - 1)) & ~(sizeof(void *) - 1);
+
+	Block *block = m_blocks;
+	if (!block || block->used + sz > block->size)
+		block = NewBlock(sz > m_blockSize ? sz : m_blockSize);
+
+	void *p = reinterpret_cast<char *>(block + 1) + block->used;
+	block->used += sz;
+	return p;
+}
+
+void KeyValues::Arena::Reset() {
+	for (Block *block = m_blocks; block;) {
+		Block *next = block->next;
+		free(block);
+		block = next;
+	}
+	m_blocks = nullptr;
 }
 
 void *KeyValues::kvmalloc(size_t sz) const {
+	if (m_arena)
+		return m_arena->Alloc(sz);
 	if (m_malloc)
 		return m_malloc(sz);
 	return malloc(sz);
 }
 
 void KeyValues::kvfree(void *ptr) const {
+	if (m_arena)
+		return; /* Released in one shot with the arena */
 	if (m_free) {
 		m_free(ptr);
 		return;
@@ -225,13 +1056,72 @@ void KeyValues::kvfree(void *ptr) const {
 
 char *KeyValues::kvstrdup(const char *ptr) const {
 	size_t sz = strlen(ptr) + 1;
-	char *s = (char *)malloc(sz);
+	char *s = (char *)kvmalloc(sz);
 	memcpy(s, ptr, sz);
 	return s;
 }
 
-KeyValues* KeyValues::FromFile(const char* file, bool use_escape_codes) {
+KeyValues *KeyValues::NewChild(const char *name) {
+	KeyValues *kv;
+	if (m_arena) {
+		kv = new (m_arena->Alloc(sizeof(KeyValues))) KeyValues();
+		kv->m_arena = m_arena;
+		kv->m_pool = m_pool;
+		kv->m_insitu = m_insitu;
+		if (name)
+			kv->name = kv->kvstrdup(name);
+		kv->keys.reserve(10);
+		return kv;
+	}
+	kv = name ? new KeyValues(name) : new KeyValues();
+	kv->m_pool = m_pool;
+	kv->m_insitu = m_insitu;
+	return kv;
+}
+
+KeyValues* KeyValues::FromFile(const char* file, bool use_escape_codes, unsigned options) {
+	auto* kv = new KeyValues();
+	kv->m_parseOptions = options;
+	if (!kv->ParseFile(file, use_escape_codes)) {
+		delete kv;
+		return nullptr;
+	}
+	return kv;
+}
+
+KeyValues* KeyValues::FromString(const char* string, bool use_escape_codes, unsigned options) {
+	auto* kv = new KeyValues();
+	kv->m_parseOptions = options;
+	if (!kv->ParseString(string, use_escape_codes)) {
+		delete kv;
+		return nullptr;
+	}
+	return kv;
+}
+
+KeyValues* KeyValues::FromFile(const char* file, Arena& arena, bool use_escape_codes) {
+	auto* kv = new KeyValues();
+	kv->m_arena = &arena;
+	if (!kv->ParseFile(file, use_escape_codes)) {
+		delete kv;
+		return nullptr;
+	}
+	return kv;
+}
+
+KeyValues* KeyValues::FromString(const char* string, Arena& arena, bool use_escape_codes) {
+	auto* kv = new KeyValues();
+	kv->m_arena = &arena;
+	if (!kv->ParseString(string, use_escape_codes)) {
+		delete kv;
+		return nullptr;
+	}
+	return kv;
+}
+
+KeyValues* KeyValues::FromFile(const char* file, InternPool& pool, bool use_escape_codes) {
 	auto* kv = new KeyValues();
+	kv->m_pool = &pool;
 	if (!kv->ParseFile(file, use_escape_codes)) {
 		delete kv;
 		return nullptr;
@@ -239,8 +1129,9 @@ KeyValues* KeyValues::FromFile(const char* file, bool use_escape_codes) {
 	return kv;
 }
 
-KeyValues* KeyValues::FromString(const char* string, bool use_escape_codes) {
+KeyValues* KeyValues::FromString(const char* string, InternPool& pool, bool use_escape_codes) {
 	auto* kv = new KeyValues();
+	kv->m_pool = &pool;
 	if (!kv->ParseString(string, use_escape_codes)) {
 		delete kv;
 		return nullptr;
@@ -248,6 +1139,58 @@ KeyValues* KeyValues::FromString(const char* string, bool use_escape_codes) {
 	return kv;
 }
 
+void KeyValues::SetInternPool(InternPool* pool) {
+	this->m_pool = pool;
+}
+
+uint32_t KeyValues::InternPool::Find(const char *s) const {
+	if (m_table.empty())
+		return 0;
+	uint32_t mask = (uint32_t)m_table.size() - 1;
+	for (uint32_t slot = HashString(s) & mask;; slot = (slot + 1) & mask) {
+		int32_t cur = m_table[slot];
+		if (cur < 0)
+			return 0;
+		if (strcmp(m_strings[cur], s) == 0)
+			return (uint32_t)cur + 1;
+	}
+}
+
+uint32_t KeyValues::InternPool::Intern(const char *s) {
+	if (m_table.empty())
+		m_table.assign(64, -1);
+	else if ((m_strings.size() + 1) * 2 > m_table.size())
+		Grow();
+
+	uint32_t hash = HashString(s);
+	uint32_t mask = (uint32_t)m_table.size() - 1;
+	uint32_t slot;
+	for (slot = hash & mask; m_table[slot] >= 0; slot = (slot + 1) & mask) {
+		if (strcmp(m_strings[m_table[slot]], s) == 0)
+			return (uint32_t)m_table[slot] + 1;
+	}
+
+	size_t len = strlen(s) + 1;
+	char *copy = (char *)m_arena.Alloc(len);
+	memcpy(copy, s, len);
+	m_table[slot] = (int32_t)m_strings.size();
+	m_strings.push_back(copy);
+	m_hashes.push_back(hash);
+	return (uint32_t)m_strings.size();
+}
+
+void KeyValues::InternPool::Grow() {
+	std::vector<int32_t> table(m_table.size() * 2, -1);
+	uint32_t mask = (uint32_t)table.size() - 1;
+	for (size_t i = 0; i < m_strings.size(); i++) {
+		uint32_t slot = m_hashes[i] & mask;
+		while (table[slot] >= 0)
+			slot = (slot + 1) & mask;
+		table[slot] = (int32_t)i;
+	}
+	m_table.swap(table);
+}
+
 
 bool KeyValues::ParseFile(const char *file, bool use_escape_codes) {
 	FILE *fs = fopen(file, "r");
@@ -260,8 +1203,8 @@ bool KeyValues::ParseFile(const char *file, bool use_escape_codes) {
 	fseek(fs, 0, SEEK_END);
 	long int size = ftell(fs);
 
-	/* Read the entire file */
-	char *buffer = static_cast<char *>(kvmalloc(size + 1));
+	/* Read the entire file. The buffer is transient, so don't carve it out of the arena */
+	char *buffer = static_cast<char *>(m_arena ? malloc(size + 1) : kvmalloc(size + 1));
 	fseek(fs, 0, SEEK_SET);
 	fread(buffer, size, 1, fs);
 	fclose(fs);
@@ -270,22 +1213,51 @@ bool KeyValues::ParseFile(const char *file, bool use_escape_codes) {
 	this->ParseString(buffer, use_escape_codes, size);
 
 	/* Free the allocated buffer */
-	kvfree(buffer);
+	if (m_arena)
+		free(buffer);
+	else
+		kvfree(buffer);
 	
 	return good;
 }
 
 bool KeyValues::ParseString(const char *string, bool escape, long long len) {
+	size_t nlen = len < 0 ? strlen(string) : (size_t)len;
+	/* The copying path never writes through the pointer */
+	return ParseStringInternal(const_cast<char *>(string), nlen, escape, false);
+}
+
+bool KeyValues::ParseBuffer(char *data, size_t len, bool take_ownership, bool use_escape_codes) {
+	if (take_ownership)
+		m_buffer = data;
+	return ParseStringInternal(data, len, use_escape_codes, true);
+}
+
+KeyValues *KeyValues::FromBuffer(char *data, size_t len, bool take_ownership, bool use_escape_codes) {
+	auto *kv = new KeyValues();
+	if (!kv->ParseBuffer(data, len, take_ownership, use_escape_codes)) {
+		if (take_ownership)
+			kv->m_buffer = nullptr; /* Failed parse leaves the buffer with the caller */
+		delete kv;
+		return nullptr;
+	}
+	return kv;
+}
+
+bool KeyValues::ParseStringInternal(char *string, size_t nlen, bool escape, bool insitu) {
 	int nline = 0, nchar = 0, bracket_level = 0;
 	bool inquote = false, incomment = false, parsed_key = false;
 	char buf[512];
 	int bufpos = 0;
+	long long tokstart = -1; /* Start of the current in-situ token, -1 if none */
 
-	size_t nlen = 0;
-	if (len < 0)
-		nlen = strlen(string);
-	else
-		nlen = len;
+	this->m_insitu = insitu;
+
+	/* Any previously built lookup index is stale once we parse into this node */
+	m_keyIndex.clear();
+	m_childIndex.clear();
+	m_keyHashes.clear();
+	m_pathCache.clear();
 
 	KeyValues *RootKV = this;
 	KeyValues *CurrentKV = this;
@@ -302,12 +1274,33 @@ bool KeyValues::ParseString(const char *string, bool escape, long long len) {
 
 	this->good = true;
 
+	/* Token helpers: the copying path accumulates into buf, the in-situ path just remembers
+	 * where the token started and patches a terminator into the source buffer */
+	auto have_token = [&]() -> bool { return insitu ? tokstart >= 0 : bufpos > 0; };
+	uint32_t tokId = 0; /* Interned id of the last taken token, 0 if not pooled */
+	auto take_token = [&](long long end, bool isKey) -> char * {
+		tokId = 0;
+		if (insitu) {
+			string[end] = 0;
+			char *t = string + tokstart;
+			tokstart = -1;
+			return t;
+		}
+		buf[bufpos] = 0;
+		bufpos = 0;
+		if (isKey && m_pool) {
+			tokId = m_pool->Intern(buf);
+			return const_cast<char *>(m_pool->String(tokId));
+		}
+		return kvstrdup(buf);
+	};
+
 	char c, nc, pc;
-	for (int i = 0; i < nlen; i++, nchar++) {
+	for (long long i = 0; i < (long long)nlen; i++, nchar++) {
 		c = string[i];
 		if (i > 0)
 			pc = string[i - 1];
-		if (i < nlen - 1)
+		if (i < (long long)nlen - 1)
 			nc = string[i + 1];
 
 		if (c == '\n') {
@@ -316,21 +1309,21 @@ bool KeyValues::ParseString(const char *string, bool escape, long long len) {
 				this->ReportError(nline, nchar, EError::MISSING_QUOTE);
 				return false;
 			}
-			
+
 			/* Save any tokens we might have at the end of the line */
-			if (bufpos > 0) {
-				buf[bufpos] = 0;
+			if (have_token()) {
+				char *tok = take_token(i, !parsed_key);
 				if (parsed_key) {
 					parsed_key = false;
-					CurrentKey.value = kvstrdup(buf);
+					CurrentKey.value = tok;
 					CurrentKV->keys.push_back(CurrentKey);
-					CurrentKey.key = CurrentKey.value = nullptr;
+					CurrentKey = Key();
 				}
 				else {
-					CurrentKey.key = kvstrdup(buf);
+					CurrentKey.key = tok;
+					CurrentKey.keyId = tokId;
 					parsed_key = true;
 				}
-				bufpos = 0;
 			}
 			incomment = false;
 			inquote = false;
@@ -353,23 +1346,39 @@ bool KeyValues::ParseString(const char *string, bool escape, long long len) {
 		if (c == '"') {
 			if (inquote) {
 				inquote = false;
-				buf[bufpos] = 0;
+				char *tok = take_token(i, !parsed_key); /* Patches the closing quote in-situ */
 				if (parsed_key) {
 					parsed_key = false;
-					CurrentKey.value = kvstrdup(buf);
+					CurrentKey.value = tok;
 					CurrentKey.quoted = true;
 					CurrentKV->keys.push_back(CurrentKey);
-					CurrentKey.key = CurrentKey.value = nullptr;
+					CurrentKey = Key();
 				}
 				else {
 					CurrentKey.quoted = true;
-					CurrentKey.key = kvstrdup(buf);
+					CurrentKey.key = tok;
+					CurrentKey.keyId = tokId;
 					parsed_key = true;
 				}
-				bufpos = 0;
 			}
 			else {
 				inquote = true;
+				/* Quoted tokens may be empty, so the token starts right after the quote */
+				if (insitu && tokstart < 0)
+					tokstart = i + 1;
+
+				/* Fast-forward to the closing quote or newline; everything in between is
+				 * eaten verbatim, so there is nothing for the per-char loop to decide */
+				size_t next = kv_find_quote_or_nl(string, (size_t)i + 1, nlen);
+				if (!insitu) {
+					size_t n = next - (size_t)(i + 1);
+					if (n > sizeof(buf) - 1 - bufpos)
+						n = sizeof(buf) - 1 - bufpos;
+					memcpy(buf + bufpos, string + i + 1, n);
+					bufpos += (int)n;
+				}
+				nchar += (int)(next - (size_t)i - 1);
+				i = (long long)next - 1;
 			}
 			continue;
 		}
@@ -378,18 +1387,34 @@ bool KeyValues::ParseString(const char *string, bool escape, long long len) {
 		if (!inquote && c == '{') {
 			KeyValues *pKV;
 			if (parsed_key) {
-				pKV = new KeyValues(CurrentKey.key);
-				kvfree(CurrentKey.key);
+				if (insitu) {
+					/* Adopt the in-buffer pointer as the section name */
+					pKV = NewChild(nullptr);
+					pKV->name = CurrentKey.key;
+				}
+				else {
+					pKV = NewChild(CurrentKey.key);
+					/* Pooled key strings belong to the InternPool */
+					if (!CurrentKey.keyId)
+						kvfree(CurrentKey.key);
+				}
 				CurrentKey.key = 0;
+				CurrentKey.keyId = 0;
 			}
-			else if (bufpos > 0) {
-				buf[bufpos] = 0;
-				bufpos = 0;
-				pKV = new KeyValues(buf);
+			else if (have_token()) {
+				if (insitu) {
+					pKV = NewChild(nullptr);
+					pKV->name = take_token(i, false);
+				}
+				else {
+					buf[bufpos] = 0;
+					bufpos = 0;
+					pKV = NewChild(buf);
+				}
 			}
 			/* In the event that buf is empty and we've not yet parsed a key, issue an error about an unnamed section */
 			else {
-				pKV = new KeyValues();
+				pKV = NewChild(nullptr);
 				this->ReportError(nline, nchar, EError::UNNAMED_SECTION);
 				return false;
 			}
@@ -411,30 +1436,48 @@ bool KeyValues::ParseString(const char *string, bool escape, long long len) {
 
 		/* Eat anything that isn't space into the buffer */
 		if (!_internal_isspace(c) || (inquote)) {
-			buf[bufpos++] = c;
+			if (insitu) {
+				if (tokstart < 0)
+					tokstart = i;
+			}
+			else
+				buf[bufpos++] = c;
+
+			/* Fast-forward over the rest of the token up to the next delimiter. A lone
+			 * '/' stops the scan but just loops back here, keeping comment semantics */
+			size_t next = kv_find_delim(string, (size_t)i + 1, nlen);
+			if (!insitu) {
+				size_t n = next - (size_t)(i + 1);
+				if (n > sizeof(buf) - 1 - bufpos)
+					n = sizeof(buf) - 1 - bufpos;
+				memcpy(buf + bufpos, string + i + 1, n);
+				bufpos += (int)n;
+			}
+			nchar += (int)(next - (size_t)i - 1);
+			i = (long long)next - 1;
 			continue;
 		}
 
 		/* Finally, handle cases where we've encountered a space and we are not in a quote */
-		if (_internal_isspace(c) && !inquote && bufpos > 0) {
+		if (_internal_isspace(c) && !inquote && have_token()) {
 			inquote = false;
-			buf[bufpos] = 0;
+			char *tok = take_token(i, !parsed_key);
 			if (parsed_key) {
 				parsed_key = false;
-				CurrentKey.value = kvstrdup(buf);
+				CurrentKey.value = tok;
 				CurrentKey.quoted = false;
 				CurrentKV->keys.push_back(CurrentKey);
-				CurrentKey.key = CurrentKey.value = nullptr;
+				CurrentKey = Key();
 			}
 			else {
 				CurrentKey.quoted = false;
-				CurrentKey.key = kvstrdup(buf);
+				CurrentKey.key = tok;
+				CurrentKey.keyId = tokId;
 				parsed_key = true;
 			}
-			bufpos = 0;
 		}
-		for (; i < nlen - 1 && _internal_isspace(string[i + 1]); i++)
-			;
+		/* Skip whitespace runs in bulk */
+		i = (long long)kv_skip_ws(string, (size_t)i + 1, nlen) - 1;
 	}
 
 	/* Verify that the parsing completed fine */
@@ -442,9 +1485,964 @@ bool KeyValues::ParseString(const char *string, bool escape, long long len) {
 		this->ReportError(-1, 0, EError::MISSING_QUOTE);
 	if (bracket_level > 0)
 		this->ReportError(-1, 0, EError::UNTERMINATED_SECTION);
+
+	/* Bulk numeric conversion while the value bytes are still hot */
+	if (good && (m_parseOptions & EAGER_NUMERIC))
+		PrecacheValues();
+
 	return good;
 }
 
+/* One finished file read. data is malloc'd and NUL-terminated, or null if the file could
+ * not be opened or read */
+struct kv_read_result {
+	size_t index; /* Slot in the caller's path array */
+	char *data;
+	size_t len;
+};
+
+/* Hands completed reads from the read stage to the parse workers. Every file produces
+ * exactly one Push (failures push a null buffer), so consumers can count pops */
+struct kv_read_queue {
+	explicit kv_read_queue(size_t total) : m_total(total) {
+	}
+
+	void Push(const kv_read_result &r) {
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_ready.push_back(r);
+		}
+		m_cv.notify_one();
+	}
+
+	/* Blocks for the next result; returns false once all of them have been handed out */
+	bool Pop(kv_read_result &r) {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_cv.wait(lock, [&] { return !m_ready.empty() || m_popped == m_total; });
+		if (m_ready.empty())
+			return false;
+		r = m_ready.back();
+		m_ready.pop_back();
+		if (++m_popped == m_total)
+			m_cv.notify_all(); /* Release any workers still waiting */
+		return true;
+	}
+
+private:
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	std::vector<kv_read_result> m_ready;
+	size_t m_popped = 0;
+	size_t m_total;
+};
+
+/* Blocking whole-file read, same shape as ParseFile's */
+static void kv_read_file_blocking(const char *path, kv_read_result &r) {
+	FILE *fs = fopen(path, "rb");
+	if (!fs)
+		return;
+	fseek(fs, 0, SEEK_END);
+	long int size = ftell(fs);
+	fseek(fs, 0, SEEK_SET);
+	char *buffer = (char *)malloc(size + 1);
+	if (size > 0 && fread(buffer, size, 1, fs) != 1) {
+		free(buffer);
+		fclose(fs);
+		return;
+	}
+	fclose(fs);
+	buffer[size] = 0;
+	r.data = buffer;
+	r.len = (size_t)size;
+}
+
+#ifdef KEYVALUES_HAS_IOURING
+
+/* Minimal raw-syscall io_uring wrapper: just enough ring to keep a window of file reads in
+ * flight from one thread. No liburing dependency. Requires the single-mmap ring layout and
+ * IORING_OP_READ (kernel 5.6+). Setup succeeding is not enough — a 5.4/5.5 kernel or an
+ * opcode-restricting seccomp policy accepts the ring and then fails every read with
+ * -EINVAL — so Init() proves the opcode with a test read and fails otherwise, selecting
+ * the blocking-reader fallback */
+struct kv_uring {
+	~kv_uring() {
+		if (m_sqes)
+			munmap(m_sqes, m_sqesSize);
+		if (m_ring)
+			munmap(m_ring, m_ringSize);
+		if (m_fd >= 0)
+			close(m_fd);
+	}
+
+	bool Init(unsigned entries) {
+		struct io_uring_params p;
+		memset(&p, 0, sizeof(p));
+		m_fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+		if (m_fd < 0)
+			return false;
+		if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+			return false;
+
+		m_ringSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		size_t cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+		if (cqSize > m_ringSize)
+			m_ringSize = cqSize;
+		m_ring = mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+					  IORING_OFF_SQ_RING);
+		if (m_ring == MAP_FAILED) {
+			m_ring = nullptr;
+			return false;
+		}
+		m_sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+		m_sqes = (struct io_uring_sqe *)mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+											 MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+		if (m_sqes == MAP_FAILED) {
+			m_sqes = nullptr;
+			return false;
+		}
+
+		char *ring = (char *)m_ring;
+		m_sqHead = (unsigned *)(ring + p.sq_off.head);
+		m_sqTail = (unsigned *)(ring + p.sq_off.tail);
+		m_sqMask = *(unsigned *)(ring + p.sq_off.ring_mask);
+		m_sqArray = (unsigned *)(ring + p.sq_off.array);
+		m_cqHead = (unsigned *)(ring + p.cq_off.head);
+		m_cqTail = (unsigned *)(ring + p.cq_off.tail);
+		m_cqMask = *(unsigned *)(ring + p.cq_off.ring_mask);
+		m_cqes = (struct io_uring_cqe *)(ring + p.cq_off.cqes);
+		m_entries = p.sq_entries;
+
+		/* Prove IORING_OP_READ actually works before committing to the ring; on kernels
+		 * older than 5.6 (or under opcode restrictions) it completes with -EINVAL */
+		int nullFd = open("/dev/null", O_RDONLY);
+		if (nullFd < 0)
+			return false;
+		char probe[8];
+		PrepRead(nullFd, probe, sizeof(probe), 0, 0);
+		uint64_t userData;
+		int res = -1;
+		bool ok = Submit(1) >= 0 && PopCQE(userData, res) && res >= 0;
+		close(nullFd);
+		return ok;
+	}
+
+	unsigned Entries() const {
+		return m_entries;
+	}
+
+	/* Queues one read of fd at `off` into buf. The caller keeps inflight <= Entries(), so
+	 * there is always SQ room */
+	void PrepRead(int fd, void *buf, unsigned len, uint64_t off, uint64_t userData) {
+		unsigned tail = *m_sqTail;
+		struct io_uring_sqe *sqe = &m_sqes[tail & m_sqMask];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = fd;
+		sqe->addr = (uint64_t)(uintptr_t)buf;
+		sqe->len = len;
+		sqe->off = off;
+		sqe->user_data = userData;
+		m_sqArray[tail & m_sqMask] = tail & m_sqMask;
+		__atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+		m_prepared++;
+	}
+
+	/* Submits everything prepared, waiting for at least `minComplete` completions */
+	int Submit(unsigned minComplete) {
+		int ret;
+		do {
+			ret = (int)syscall(__NR_io_uring_enter, m_fd, m_prepared, minComplete,
+							   minComplete ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+		} while (ret < 0 && errno == EINTR);
+		if (ret >= 0)
+			m_prepared -= (unsigned)ret;
+		return ret;
+	}
+
+	bool PopCQE(uint64_t &userData, int &res) {
+		unsigned head = *m_cqHead;
+		if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE))
+			return false;
+		userData = m_cqes[head & m_cqMask].user_data;
+		res = m_cqes[head & m_cqMask].res;
+		__atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+
+private:
+	int m_fd = -1;
+	unsigned m_entries = 0;
+	unsigned m_prepared = 0;
+	void *m_ring = nullptr;
+	size_t m_ringSize = 0;
+	struct io_uring_sqe *m_sqes = nullptr;
+	size_t m_sqesSize = 0;
+	unsigned *m_sqHead, *m_sqTail, *m_sqArray;
+	unsigned m_sqMask;
+	unsigned *m_cqHead, *m_cqTail;
+	unsigned m_cqMask;
+	struct io_uring_cqe *m_cqes;
+};
+
+/* Read stage: opens files and keeps up to Entries() reads in flight, pushing each buffer
+ * to the queue the moment it completes. Short reads are resubmitted at their offset */
+static void kv_uring_read_stage(const char *const *paths, size_t numFiles, kv_read_queue &queue,
+								kv_uring &ring) {
+	struct inflight {
+		size_t index;
+		int fd;
+		char *data;
+		size_t size;
+		size_t done;
+	};
+	const unsigned depth = ring.Entries();
+	std::vector<inflight> slots(depth);
+	std::vector<unsigned> freeSlots(depth);
+	std::vector<bool> active(depth, false);
+	for (unsigned i = 0; i < depth; i++)
+		freeSlots[i] = depth - 1 - i;
+	unsigned numInflight = 0;
+	size_t nextFile = 0;
+	bool ringDead = false;
+
+	/* Handles one completion; returns true if the slot was retired (vs resubmitted) */
+	auto reapOne = [&](unsigned slot, int res) {
+		inflight &f = slots[slot];
+		if (res == -EINVAL) {
+			/* The kernel took the SQE but rejected how it was formed — an opcode or flag
+			 * restriction that slipped past the Init probe. Nothing was read, so this is
+			 * not a file failure: retry it with a blocking read and stop trusting the
+			 * ring, which sends the rest of the batch down the salvage path below */
+			ringDead = true;
+			close(f.fd);
+			free(f.data);
+			kv_read_result r = { f.index, nullptr, 0 };
+			kv_read_file_blocking(paths[f.index], r);
+			queue.Push(r);
+			freeSlots.push_back(slot);
+			active[slot] = false;
+			numInflight--;
+			return true;
+		}
+		if (res <= 0) {
+			/* Read error, or EOF before the stat'd size (file shrank): fail the file */
+			close(f.fd);
+			free(f.data);
+			queue.Push({ f.index, nullptr, 0 });
+		}
+		else if (f.done + (size_t)res < f.size) {
+			/* Short read; pick up where it left off */
+			f.done += (size_t)res;
+			ring.PrepRead(f.fd, f.data + f.done, (unsigned)(f.size - f.done), f.done, slot);
+			return false;
+		}
+		else {
+			close(f.fd);
+			f.data[f.size] = 0;
+			queue.Push({ f.index, f.data, f.size });
+		}
+		freeSlots.push_back(slot);
+		active[slot] = false;
+		numInflight--;
+		return true;
+	};
+
+	while (nextFile < numFiles || numInflight > 0) {
+		/* Start new files while there's a free slot in the window */
+		while (nextFile < numFiles && numInflight < depth) {
+			size_t i = nextFile++;
+			int fd = open(paths[i], O_RDONLY);
+			struct stat st;
+			if (fd < 0 || fstat(fd, &st) != 0) {
+				if (fd >= 0)
+					close(fd);
+				queue.Push({ i, nullptr, 0 });
+				continue;
+			}
+			if (st.st_size == 0) {
+				close(fd);
+				char *d = (char *)malloc(1);
+				d[0] = 0;
+				queue.Push({ i, d, 0 });
+				continue;
+			}
+			unsigned slot = freeSlots.back();
+			freeSlots.pop_back();
+			slots[slot] = { i, fd, (char *)malloc((size_t)st.st_size + 1), (size_t)st.st_size, 0 };
+			active[slot] = true;
+			ring.PrepRead(fd, slots[slot].data, (unsigned)slots[slot].size, 0, slot);
+			numInflight++;
+		}
+
+		if (ring.Submit(numInflight ? 1 : 0) < 0)
+			ringDead = true;
+
+		uint64_t userData;
+		int res;
+		while (ring.PopCQE(userData, res))
+			reapOne((unsigned)userData, res);
+
+		if (ringDead) {
+			/* The ring died underneath us — enter failed, or a completion came back
+			 * -EINVAL. Finish everything with blocking reads rather than dropping files */
+			for (unsigned slot = 0; slot < depth && numInflight > 0; slot++) {
+				if (!active[slot])
+					continue;
+				close(slots[slot].fd);
+				free(slots[slot].data);
+				kv_read_result r = { slots[slot].index, nullptr, 0 };
+				kv_read_file_blocking(paths[slots[slot].index], r);
+				queue.Push(r);
+				active[slot] = false;
+				numInflight--;
+			}
+			for (; nextFile < numFiles; nextFile++) {
+				kv_read_result r = { nextFile, nullptr, 0 };
+				kv_read_file_blocking(paths[nextFile], r);
+				queue.Push(r);
+			}
+			return;
+		}
+	}
+}
+
+#endif /* KEYVALUES_HAS_IOURING */
+
+std::vector<KeyValues *> KeyValues::LoadFiles(const char *const *paths, size_t numFiles, int numThreads,
+											  bool use_escape_codes) {
+	std::vector<KeyValues *> results(numFiles, nullptr);
+	if (numFiles == 0)
+		return results;
+
+	if (numThreads <= 0)
+		numThreads = (int)std::thread::hardware_concurrency();
+	if (numThreads < 1)
+		numThreads = 1;
+	if ((size_t)numThreads > numFiles)
+		numThreads = (int)numFiles;
+
+	kv_read_queue queue(numFiles);
+
+	/* Parse workers drain the queue as buffers arrive; each parse touches only
+	 * per-instance state */
+	auto parseWorker = [&]() {
+		kv_read_result r;
+		while (queue.Pop(r)) {
+			if (!r.data)
+				continue;
+			auto *kv = new KeyValues();
+			if (kv->ParseString(r.data, use_escape_codes, (long long)r.len))
+				results[r.index] = kv;
+			else
+				delete kv;
+			free(r.data);
+		}
+	};
+
+	std::atomic<size_t> nextRead(0);
+	std::vector<std::thread> readers;
+#ifdef KEYVALUES_HAS_IOURING
+	kv_uring ring;
+	bool haveRing = ring.Init(64);
+	if (haveRing)
+		readers.emplace_back([&]() { kv_uring_read_stage(paths, numFiles, queue, ring); });
+#else
+	bool haveRing = false;
+#endif
+	if (!haveRing) {
+		/* Blocking fallback: a few reader threads split the file list off a shared counter
+		 * and feed the same queue. More than a handful just contends the disk */
+		int numReaders = numThreads < 4 ? numThreads : 4;
+		if ((size_t)numReaders > numFiles)
+			numReaders = (int)numFiles;
+		readers.reserve(numReaders);
+		for (int t = 0; t < numReaders; t++) {
+			readers.emplace_back([&]() {
+				for (size_t i = nextRead.fetch_add(1); i < numFiles; i = nextRead.fetch_add(1)) {
+					kv_read_result r = { i, nullptr, 0 };
+					kv_read_file_blocking(paths[i], r);
+					queue.Push(r);
+				}
+			});
+		}
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(numThreads - 1);
+	for (int t = 1; t < numThreads; t++)
+		workers.emplace_back(parseWorker);
+	parseWorker();
+	for (auto &worker : workers)
+		worker.join();
+	for (auto &reader : readers)
+		reader.join();
+	return results;
+}
+
+KeyValues::Parser::Parser(bool use_escape_codes, Arena *arena)
+	: m_stackpos(0), m_bufpos(0), m_nline(0), m_nchar(0), m_bracketLevel(0), m_inquote(false), m_incomment(false),
+	  m_parsedKey(false), m_pending(0), m_prevChar(0), m_hasPending(false) {
+	(void)use_escape_codes;
+	m_root = new KeyValues();
+	m_root->m_arena = arena;
+	m_root->good = true;
+	m_stack[0] = m_root;
+	m_curKey.key = m_curKey.value = nullptr;
+}
+
+KeyValues::Parser::~Parser() {
+	if (m_curKey.key)
+		m_root ? m_root->kvfree(m_curKey.key) : free(m_curKey.key);
+	delete m_root;
+}
+
+void KeyValues::Parser::SetErrorCallback(pfnErrorCallback_t callback) {
+	if (m_root)
+		m_root->SetErrorCallback(callback);
+}
+
+void KeyValues::Parser::SaveToken(bool quotedTok) {
+	KeyValues *CurrentKV = m_stack[m_stackpos];
+	m_buf[m_bufpos] = 0;
+	m_bufpos = 0;
+	if (m_parsedKey) {
+		m_parsedKey = false;
+		m_curKey.value = m_root->kvstrdup(m_buf);
+		m_curKey.quoted = quotedTok;
+		CurrentKV->keys.push_back(m_curKey);
+		m_curKey.key = m_curKey.value = nullptr;
+	}
+	else {
+		m_curKey.quoted = quotedTok;
+		m_curKey.key = m_root->kvstrdup(m_buf);
+		m_parsedKey = true;
+	}
+}
+
+bool KeyValues::Parser::ProcessChar(char c, char nc) {
+	char pc = m_prevChar;
+	m_prevChar = c;
+	m_nchar++;
+
+	if (c == '\n') {
+		if (m_inquote) {
+			m_root->ReportError(m_nline, m_nchar, EError::MISSING_QUOTE);
+			return false;
+		}
+		if (m_bufpos > 0)
+			SaveToken(false);
+		m_incomment = false;
+		m_nline++;
+		m_nchar = 0;
+		return true;
+	}
+
+	if (c == '/' && (pc == '/' || nc == '/') && !m_inquote) {
+		m_incomment = true;
+		return true;
+	}
+
+	if (m_incomment)
+		return true;
+
+	if (c == '"') {
+		if (m_inquote) {
+			m_inquote = false;
+			SaveToken(true);
+		}
+		else
+			m_inquote = true;
+		return true;
+	}
+
+	if (!m_inquote && c == '{') {
+		KeyValues *CurrentKV = m_stack[m_stackpos];
+		KeyValues *pKV;
+		if (m_parsedKey) {
+			pKV = m_root->NewChild(m_curKey.key);
+			m_root->kvfree(m_curKey.key);
+			m_curKey.key = nullptr;
+			m_parsedKey = false;
+		}
+		else if (m_bufpos > 0) {
+			m_buf[m_bufpos] = 0;
+			m_bufpos = 0;
+			pKV = m_root->NewChild(m_buf);
+		}
+		else {
+			m_root->ReportError(m_nline, m_nchar, EError::UNNAMED_SECTION);
+			return false;
+		}
+		if (m_curKey.quoted)
+			pKV->quoted = true;
+		CurrentKV->child_sections.push_back(pKV);
+		m_stack[++m_stackpos] = pKV;
+		m_bracketLevel++;
+		return true;
+	}
+
+	if (!m_inquote && c == '}') {
+		if (m_stackpos > 0)
+			m_stackpos--;
+		m_bracketLevel--;
+		return true;
+	}
+
+	if (!_internal_isspace(c) || m_inquote) {
+		if (m_bufpos < (int)sizeof(m_buf) - 1)
+			m_buf[m_bufpos++] = c;
+		return true;
+	}
+
+	if (m_bufpos > 0)
+		SaveToken(false);
+	return true;
+}
+
+bool KeyValues::Parser::Feed(const char *chunk, size_t len) {
+	if (!m_root || !m_root->good)
+		return false;
+	for (size_t i = 0; i < len; i++) {
+		if (m_hasPending && !ProcessChar(m_pending, chunk[i]))
+			return false;
+		m_pending = chunk[i];
+		m_hasPending = true;
+	}
+	return true;
+}
+
+KeyValues *KeyValues::Parser::Finish() {
+	if (!m_root)
+		return nullptr;
+
+	if (m_root->good && m_hasPending) {
+		ProcessChar(m_pending, 0);
+		m_hasPending = false;
+	}
+
+	if (m_inquote)
+		m_root->ReportError(-1, 0, EError::MISSING_QUOTE);
+	if (m_bracketLevel > 0)
+		m_root->ReportError(-1, 0, EError::UNTERMINATED_SECTION);
+
+	KeyValues *result = m_root;
+	m_root = nullptr;
+	if (!result->good) {
+		delete result;
+		return nullptr;
+	}
+	return result;
+}
+
+bool KeyValues::CompileToFile(const char *file) {
+	std::vector<CompiledNode> nodes;
+	std::vector<CompiledKey> ckeys;
+	std::string strtab;
+	std::unordered_map<std::string, uint32_t> interned;
+
+	/* Offset 0 is always the empty string */
+	strtab.push_back(0);
+	auto intern = [&](const char *s) -> uint32_t {
+		if (!s || !*s)
+			return 0;
+		auto it = interned.find(s);
+		if (it != interned.end())
+			return it->second;
+		uint32_t off = (uint32_t)strtab.size();
+		strtab.append(s, strlen(s) + 1);
+		interned.emplace(s, off);
+		return off;
+	};
+
+	/* Flatten breadth-first so each node's children end up contiguous */
+	std::vector<KeyValues *> order;
+	order.push_back(this);
+	nodes.emplace_back();
+	for (size_t n = 0; n < order.size(); n++) {
+		KeyValues *kv = order[n];
+		CompiledNode node = {};
+		node.name = intern(kv->name);
+		node.nameHash = kv->name ? HashString(kv->name) : 0;
+		node.firstKey = (uint32_t)ckeys.size();
+		node.numKeys = (uint32_t)kv->keys.size();
+		for (auto &k : kv->keys) {
+			CompiledKey ck = {};
+			ck.key = intern(k.key);
+			ck.value = intern(k.value);
+			ck.keyHash = k.key ? HashString(k.key) : 0;
+			ck.cached = (uint8_t)k.cached;
+			ck.quoted = k.quoted ? 1 : 0;
+			switch (k.cached) {
+			case Key::ELastCached::INT:
+				ck.cachedv.ival = k.cachedv.ival;
+				break;
+			case Key::ELastCached::FLOAT:
+				ck.cachedv.fval = k.cachedv.fval;
+				break;
+			case Key::ELastCached::BOOL:
+				ck.cachedv.bval = k.cachedv.bval;
+				break;
+			case Key::ELastCached::NONE:
+				/* Convert numerics eagerly so the loader never has to parse */
+				if (k.value && k.value[0]) {
+					char *end = nullptr;
+					errno = 0;
+					long int iv = strtol(k.value, &end, 10);
+					if (errno == 0 && end && *end == 0) {
+						ck.cached = (uint8_t)Key::ELastCached::INT;
+						ck.cachedv.ival = iv;
+						break;
+					}
+					errno = 0;
+					double fv = strtod(k.value, &end);
+					if (errno == 0 && end && *end == 0) {
+						ck.cached = (uint8_t)Key::ELastCached::FLOAT;
+						ck.cachedv.fval = fv;
+					}
+				}
+				break;
+			}
+			ckeys.push_back(ck);
+		}
+		node.firstChild = (uint32_t)order.size();
+		node.numChildren = (uint32_t)kv->child_sections.size();
+		for (auto section : kv->child_sections) {
+			order.push_back(section);
+			nodes.emplace_back();
+		}
+		nodes[n] = node;
+	}
+
+	CompiledHeader hdr = {};
+	hdr.magic = COMPILED_MAGIC;
+	hdr.version = COMPILED_VERSION;
+	hdr.numNodes = (uint32_t)nodes.size();
+	hdr.numKeys = (uint32_t)ckeys.size();
+	hdr.strTabOffset = (uint32_t)(sizeof(CompiledHeader) + nodes.size() * sizeof(CompiledNode) +
+								  ckeys.size() * sizeof(CompiledKey));
+	hdr.strTabSize = (uint32_t)strtab.size();
+
+	FILE *fs = fopen(file, "wb");
+	if (!fs)
+		return false;
+
+	bool ok = fwrite(&hdr, sizeof(hdr), 1, fs) == 1;
+	ok = ok && fwrite(nodes.data(), sizeof(CompiledNode), nodes.size(), fs) == nodes.size();
+	if (!ckeys.empty())
+		ok = ok && fwrite(ckeys.data(), sizeof(CompiledKey), ckeys.size(), fs) == ckeys.size();
+	ok = ok && fwrite(strtab.data(), 1, strtab.size(), fs) == strtab.size();
+	fclose(fs);
+	return ok;
+}
+
+KeyValues::Compiled::Compiled()
+	: m_header(nullptr), m_nodes(nullptr), m_keys(nullptr), m_strTab(nullptr), m_map(nullptr), m_mapSize(0),
+	  m_mapped(false) {
+}
+
+KeyValues::Compiled::~Compiled() {
+	if (m_map) {
+#ifndef _WIN32
+		if (m_mapped) {
+			munmap(m_map, m_mapSize);
+			return;
+		}
+#endif
+		free(m_map);
+	}
+}
+
+bool KeyValues::Compiled::Load(const char *file) {
+#ifndef _WIN32
+	int fd = open(file, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CompiledHeader)) {
+		close(fd);
+		return false;
+	}
+	void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+	m_map = map;
+	m_mapSize = st.st_size;
+	m_mapped = true;
+#else
+	/* No mmap here; fall back to reading the file into one block */
+	FILE *fs = fopen(file, "rb");
+	if (!fs)
+		return false;
+	fseek(fs, 0, SEEK_END);
+	long int size = ftell(fs);
+	fseek(fs, 0, SEEK_SET);
+	if (size < (long int)sizeof(CompiledHeader)) {
+		fclose(fs);
+		return false;
+	}
+	m_map = malloc(size);
+	if (fread(m_map, size, 1, fs) != 1) {
+		fclose(fs);
+		free(m_map);
+		m_map = nullptr;
+		return false;
+	}
+	fclose(fs);
+	m_mapSize = size;
+#endif
+
+	auto *hdr = static_cast<const CompiledHeader *>(m_map);
+
+	/* Validate the header before trusting any of the offsets */
+	size_t nodesEnd = sizeof(CompiledHeader) + (size_t)hdr->numNodes * sizeof(CompiledNode);
+	size_t keysEnd = nodesEnd + (size_t)hdr->numKeys * sizeof(CompiledKey);
+	if (hdr->magic != COMPILED_MAGIC || hdr->version != COMPILED_VERSION || hdr->numNodes == 0 ||
+		hdr->strTabOffset != keysEnd || (size_t)hdr->strTabOffset + hdr->strTabSize != m_mapSize ||
+		hdr->strTabSize == 0) {
+		return false;
+	}
+
+	const char *base = static_cast<const char *>(m_map);
+	const char *strTab = base + hdr->strTabOffset;
+
+	/* The string table must be terminated so no string can run off the map */
+	if (strTab[hdr->strTabSize - 1] != 0)
+		return false;
+
+	/* The header checks out, but a truncated or corrupted file can still carry
+	 * per-record offsets pointing anywhere. Validate every node and key up front
+	 * so View never has to range-check on the hot path. The walk is O(n), same as
+	 * the mmap fault-in cost we already pay */
+	auto *nodes = reinterpret_cast<const CompiledNode *>(base + sizeof(CompiledHeader));
+	auto *keys = reinterpret_cast<const CompiledKey *>(base + nodesEnd);
+	for (uint32_t i = 0; i < hdr->numNodes; ++i) {
+		const CompiledNode &n = nodes[i];
+		if (n.name >= hdr->strTabSize)
+			return false;
+		/* Subtraction form: firstChild + numChildren could wrap uint32 */
+		if (n.firstChild > hdr->numNodes || n.numChildren > hdr->numNodes - n.firstChild)
+			return false;
+		if (n.firstKey > hdr->numKeys || n.numKeys > hdr->numKeys - n.firstKey)
+			return false;
+	}
+	for (uint32_t i = 0; i < hdr->numKeys; ++i) {
+		if (keys[i].key >= hdr->strTabSize || keys[i].value >= hdr->strTabSize)
+			return false;
+	}
+
+	m_header = hdr;
+	m_nodes = nodes;
+	m_keys = keys;
+	m_strTab = strTab;
+	return true;
+}
+
+KeyValues::Compiled::View KeyValues::Compiled::Root() const {
+	return Good() ? View(this, m_nodes) : View();
+}
+
+const char *KeyValues::Compiled::View::Name() const {
+	return m_node ? m_owner->String(m_node->name) : nullptr;
+}
+
+uint32_t KeyValues::Compiled::View::NumKeys() const {
+	return m_node ? m_node->numKeys : 0;
+}
+
+uint32_t KeyValues::Compiled::View::NumChildren() const {
+	return m_node ? m_node->numChildren : 0;
+}
+
+KeyValues::Compiled::View KeyValues::Compiled::View::Child(uint32_t idx) const {
+	if (!m_node || idx >= m_node->numChildren)
+		return View();
+	return View(m_owner, m_owner->m_nodes + m_node->firstChild + idx);
+}
+
+const KeyValues::CompiledKey *KeyValues::Compiled::View::FindKey(const char *key) const {
+	if (!m_node)
+		return nullptr;
+	uint32_t hash = HashString(key);
+	const CompiledKey *base = m_owner->m_keys + m_node->firstKey;
+	for (uint32_t i = 0; i < m_node->numKeys; i++) {
+		/* The precomputed hash filters out nearly every strcmp */
+		if (base[i].keyHash == hash && strcmp(m_owner->String(base[i].key), key) == 0)
+			return &base[i];
+	}
+	return nullptr;
+}
+
+KeyValues::Compiled::View KeyValues::Compiled::View::GetChild(const char *name) const {
+	if (!m_node)
+		return View();
+	uint32_t hash = HashString(name);
+	for (uint32_t i = 0; i < m_node->numChildren; i++) {
+		const CompiledNode *child = m_owner->m_nodes + m_node->firstChild + i;
+		if (child->nameHash == hash && strcmp(m_owner->String(child->name), name) == 0)
+			return View(m_owner, child);
+	}
+	return View();
+}
+
+bool KeyValues::Compiled::View::HasKey(const char *key) const {
+	return FindKey(key) != nullptr;
+}
+
+const char *KeyValues::Compiled::View::GetString(const char *key, const char *_default) const {
+	const CompiledKey *k = FindKey(key);
+	return k ? m_owner->String(k->value) : _default;
+}
+
+int KeyValues::Compiled::View::GetInt(const char *key, int _default) const {
+	const CompiledKey *k = FindKey(key);
+	if (!k)
+		return _default;
+	if (k->cached == (uint8_t)Key::ELastCached::INT)
+		return (int)k->cachedv.ival;
+	errno = 0;
+	long int v = strtol(m_owner->String(k->value), nullptr, 10);
+	return errno == 0 ? (int)v : _default;
+}
+
+float KeyValues::Compiled::View::GetFloat(const char *key, float _default) const {
+	return (float)GetDouble(key, _default);
+}
+
+double KeyValues::Compiled::View::GetDouble(const char *key, double _default) const {
+	const CompiledKey *k = FindKey(key);
+	if (!k)
+		return _default;
+	if (k->cached == (uint8_t)Key::ELastCached::FLOAT)
+		return k->cachedv.fval;
+	if (k->cached == (uint8_t)Key::ELastCached::INT)
+		return (double)k->cachedv.ival;
+	errno = 0;
+	double v = strtod(m_owner->String(k->value), nullptr);
+	return errno == 0 ? v : _default;
+}
+
+bool KeyValues::Compiled::View::GetBool(const char *key, bool _default) const {
+	const CompiledKey *k = FindKey(key);
+	if (!k)
+		return _default;
+	if (k->cached == (uint8_t)Key::ELastCached::BOOL)
+		return k->cachedv.bval;
+	if (k->cached == (uint8_t)Key::ELastCached::INT)
+		return k->cachedv.ival != 0;
+	const char *v = m_owner->String(k->value);
+	if (strcasecmp(v, "true") == 0 || strcmp(v, "1") == 0)
+		return true;
+	if (strcasecmp(v, "false") == 0 || strcmp(v, "0") == 0)
+		return false;
+	return _default;
+}
+
+uint32_t KeyValues::HashString(const char *s) {
+	/* FNV-1a */
+	uint32_t h = 2166136261u;
+	for (; *s; s++) {
+		h ^= (uint8_t)*s;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+void KeyValues::IndexInsert(std::vector<int32_t> &index, bool children, int32_t value) {
+	const char *name = children ? child_sections[value]->name : keys[value].key;
+	if (!name)
+		return;
+	uint32_t mask = (uint32_t)index.size() - 1;
+	for (uint32_t slot = HashString(name) & mask;; slot = (slot + 1) & mask) {
+		int32_t cur = index[slot];
+		if (cur < 0) {
+			index[slot] = value;
+			return;
+		}
+		const char *curname = children ? child_sections[cur]->name : keys[cur].key;
+		/* Keep the first occurrence of a duplicate, matching the linear scan */
+		if (curname && strcmp(curname, name) == 0)
+			return;
+	}
+}
+
+int32_t KeyValues::IndexLookup(const std::vector<int32_t> &index, bool children, const char *name) const {
+	uint32_t mask = (uint32_t)index.size() - 1;
+	for (uint32_t slot = HashString(name) & mask;; slot = (slot + 1) & mask) {
+		int32_t cur = index[slot];
+		if (cur < 0)
+			return -1;
+		const char *curname = children ? child_sections[cur]->name : keys[cur].key;
+		if (curname && strcmp(curname, name) == 0)
+			return cur;
+	}
+}
+
+void KeyValues::BuildIndex(bool recursive) {
+	m_keyIndex.clear();
+	m_childIndex.clear();
+
+	/* Size the tables to a power of two at < 50% load */
+	if (!keys.empty()) {
+		size_t cap = 16;
+		while (cap < keys.size() * 2)
+			cap <<= 1;
+		m_keyIndex.assign(cap, -1);
+		for (size_t i = 0; i < keys.size(); i++)
+			IndexInsert(m_keyIndex, false, (int32_t)i);
+	}
+
+	if (!child_sections.empty()) {
+		size_t cap = 16;
+		while (cap < child_sections.size() * 2)
+			cap <<= 1;
+		m_childIndex.assign(cap, -1);
+		for (size_t i = 0; i < child_sections.size(); i++)
+			IndexInsert(m_childIndex, true, (int32_t)i);
+	}
+
+	if (recursive) {
+		for (auto section : child_sections)
+			section->BuildIndex(true);
+	}
+}
+
+void KeyValues::RefreshKeyHashes() {
+	m_keyHashes.resize(keys.size());
+	for (size_t i = 0; i < keys.size(); i++)
+		m_keyHashes[i] = keys[i].key ? HashString(keys[i].key) : 0;
+}
+
+KeyValues::Key *KeyValues::FindKey(const char *key) {
+	/* Build the index lazily once a section gets big enough for linear scans to hurt */
+	if (m_keyIndex.empty() && keys.size() > INDEX_BUILD_THRESHOLD)
+		BuildIndex();
+
+	if (!m_keyIndex.empty()) {
+		int32_t i = IndexLookup(m_keyIndex, false, key);
+		return i >= 0 ? &keys[i] : nullptr;
+	}
+
+	/* Linear path: scan the packed hash array and only confirm hits with strcmp,
+	 * or a 32-bit id compare when both sides are interned */
+	if (m_keyHashes.size() != keys.size())
+		RefreshKeyHashes();
+
+	uint32_t hash = HashString(key);
+	uint32_t id = m_pool ? m_pool->Find(key) : 0;
+	for (size_t i = 0; i < m_keyHashes.size(); i++) {
+		if (m_keyHashes[i] != hash)
+			continue;
+		if (id && keys[i].keyId) {
+			if (keys[i].keyId == id)
+				return &keys[i];
+		}
+		else if (keys[i].key && strcmp(keys[i].key, key) == 0)
+			return &keys[i];
+	}
+	return nullptr;
+}
+
 void KeyValues::ReportError(int line, int _char, EError err) {
 	if (pCallback)
 		pCallback(line, _char, err);
@@ -488,72 +2486,183 @@ void KeyValues::DumpToStreamInternal(FILE *fs, int indent) {
 		fprintf(fs, "%s}\n", buf);
 }
 
-bool KeyValues::GetBool(const char *key, bool _default) {
-	for (auto _key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			bool ok = false;
-			bool b = _key.ReadBool(ok);
-			if (ok)
-				return b;
-			return _default;
+void KeyValues::DumpToBuffer(std::string &out) const {
+	this->DumpToBufferInternal(out, 0);
+}
+
+void KeyValues::DumpToBufferInternal(std::string &out, int indent) const {
+	if (indent > MAX_INDENT_LEVEL)
+		return;
+
+	/* The indent run is computed once per section and appended as raw bytes */
+	char ind[MAX_INDENT_LEVEL + 2];
+	memset(ind, '\t', indent);
+	size_t ilen = indent;
+
+	if (this->name) {
+		out.append(ind, ilen);
+		if (this->quoted) {
+			out += '"';
+			out += this->name;
+			out += '"';
 		}
+		else
+			out += this->name;
+		out += '\n';
+		out.append(ind, ilen);
+		out += "{\n";
+		ind[ilen++] = '\t';
+	}
+
+	for (auto &key : this->keys) {
+		if (!key.key)
+			continue;
+		out.append(ind, ilen);
+		if (key.quoted) {
+			out += '"';
+			out += key.key;
+			out += "\" \"";
+		}
+		else {
+			out += key.key;
+			out += " \"";
+		}
+		if (key.value)
+			out += key.value;
+		out += "\"\n";
+	}
+
+	for (auto section : this->child_sections)
+		section->DumpToBufferInternal(out, indent + 1);
+
+	if (this->name) {
+		out.append(ind, ilen - 1);
+		out += "}\n";
+	}
+}
+
+bool KeyValues::GetBool(const char *key, bool _default) {
+	Key *_key = FindKey(key);
+	if (_key) {
+		bool ok = false;
+		bool b = m_frozen ? _key->PeekBool(ok) : _key->ReadBool(ok);
+		if (ok)
+			return b;
 	}
 	return _default;
 }
 
 int KeyValues::GetInt(const char *key, int _default) {
-	for (auto _key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			bool ok = false;
-			int i = (int)_key.ReadInt(ok);
-			if (ok)
-				return i;
-			return _default;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		bool ok = false;
+		int i = (int)(m_frozen ? _key->PeekInt(ok) : _key->ReadInt(ok));
+		if (ok)
+			return i;
 	}
 	return _default;
 }
 
 float KeyValues::GetFloat(const char *key, float _default) {
-	for (auto _key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			bool ok = false;
-			float f = (float)_key.ReadFloat(ok);
-			if (ok)
-				return f;
-			return _default;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		bool ok = false;
+		float f = (float)(m_frozen ? _key->PeekFloat(ok) : _key->ReadFloat(ok));
+		if (ok)
+			return f;
 	}
 	return _default;
 }
 
 double KeyValues::GetDouble(const char *key, double _default) {
-	for (auto _key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			bool ok = false;
-			double f = _key.ReadFloat(ok);
-			if (ok)
-				return f;
-			return _default;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		bool ok = false;
+		double f = m_frozen ? _key->PeekFloat(ok) : _key->ReadFloat(ok);
+		if (ok)
+			return f;
 	}
 	return _default;
 }
 
 const char *KeyValues::GetString(const char *key, const char *_default) {
-	for (auto _key : this->keys) {
-		if (_key.key && strcmp(key, _key.key) == 0)
-			return _key.value;
+	Key *_key = FindKey(key);
+	return _key ? _key->value : _default;
+}
+
+bool KeyValues::HasKey(const char *key) {
+	return FindKey(key) != nullptr;
+}
+
+KeyValues::Key *KeyValues::GetByPath(const char *path) {
+	auto it = m_pathCache.find(path);
+	if (it != m_pathCache.end())
+		return it->second.node->FindKey(path + it->second.keyPos);
+
+	/* Walk the sections; the final segment names a key */
+	KeyValues *node = this;
+	const char *seg = path;
+	for (;;) {
+		const char *slash = strchr(seg, '/');
+		if (!slash)
+			break;
+		char name[256];
+		size_t len = (size_t)(slash - seg);
+		if (len >= sizeof(name))
+			return nullptr;
+		memcpy(name, seg, len);
+		name[len] = 0;
+		node = node->GetChild(name);
+		if (!node)
+			return nullptr;
+		seg = slash + 1;
+	}
+	if (!*seg)
+		return nullptr;
+
+	Key *k = node->FindKey(seg);
+	/* A frozen tree never writes the cache; misses just pay the walk */
+	if (k && !m_frozen)
+		m_pathCache.emplace(path, PathEntry { node, (uint32_t)(seg - path) });
+	return k;
+}
+
+int KeyValues::GetIntByPath(const char *path, int _default) {
+	Key *_key = GetByPath(path);
+	if (_key) {
+		bool ok = false;
+		long int v = m_frozen ? _key->PeekInt(ok) : _key->ReadInt(ok);
+		if (ok)
+			return (int)v;
 	}
 	return _default;
 }
 
-bool KeyValues::HasKey(const char *key) {
-	for (auto _key : this->keys) {
-		if (_key.key && strcmp(key, _key.key) == 0)
-			return true;
+bool KeyValues::GetBoolByPath(const char *path, bool _default) {
+	Key *_key = GetByPath(path);
+	if (_key) {
+		bool ok = false;
+		bool b = m_frozen ? _key->PeekBool(ok) : _key->ReadBool(ok);
+		if (ok)
+			return b;
 	}
-	return false;
+	return _default;
+}
+
+double KeyValues::GetDoubleByPath(const char *path, double _default) {
+	Key *_key = GetByPath(path);
+	if (_key) {
+		bool ok = false;
+		double f = m_frozen ? _key->PeekFloat(ok) : _key->ReadFloat(ok);
+		if (ok)
+			return f;
+	}
+	return _default;
+}
+
+const char *KeyValues::GetStringByPath(const char *path, const char *_default) {
+	Key *_key = GetByPath(path);
+	return _key ? _key->value : _default;
 }
 
 bool KeyValues::Key::ReadBool(bool &ok) {
@@ -594,8 +2703,8 @@ long int KeyValues::Key::ReadInt(bool &ok) {
 		return 0;
 	}
 
-	long int v = strtol(this->value, nullptr, 10);
-	if (errno == 0) {
+	long int v;
+	if (kv_parse_long(this->value, v)) {
 		this->cached = ELastCached ::INT;
 		this->cachedv.ival = v;
 		return v;
@@ -616,8 +2725,8 @@ double KeyValues::Key::ReadFloat(bool &ok) {
 		return 0.0f;
 	}
 
-	double f = strtod(this->value, nullptr);
-	if (errno == 0) {
+	double f;
+	if (kv_parse_double(this->value, f)) {
 		this->cached = ELastCached::FLOAT;
 		this->cachedv.fval = f;
 		return f;
@@ -626,7 +2735,95 @@ double KeyValues::Key::ReadFloat(bool &ok) {
 	return 0.0f;
 }
 
+bool KeyValues::Key::PeekBool(bool &ok) const {
+	ok = true;
+	if (this->cached == ELastCached::BOOL)
+		return this->cachedv.bval;
+	if (!this->value) {
+		ok = false;
+		return false;
+	}
+	if (strcasecmp(this->value, "true") == 0 || strcmp(this->value, "1") == 0)
+		return true;
+	if (strcasecmp(this->value, "false") == 0 || strcmp(this->value, "0") == 0)
+		return false;
+	ok = false;
+	return false;
+}
+
+long int KeyValues::Key::PeekInt(bool &ok) const {
+	ok = true;
+	if (this->cached == ELastCached::INT)
+		return this->cachedv.ival;
+	long int v;
+	if (this->value && kv_parse_long(this->value, v))
+		return v;
+	ok = false;
+	return 0;
+}
+
+double KeyValues::Key::PeekFloat(bool &ok) const {
+	ok = true;
+	if (this->cached == ELastCached::FLOAT)
+		return this->cachedv.fval;
+	double f;
+	if (this->value && kv_parse_double(this->value, f))
+		return f;
+	ok = false;
+	return 0.0f;
+}
+
+void KeyValues::PrecacheValues() {
+	for (auto &k : this->keys) {
+		if (!k.value || k.cached != Key::ELastCached::NONE)
+			continue;
+		long l;
+		double d;
+		if (kv_parse_long(k.value, l)) {
+			k.cachedv.ival = l;
+			k.cached = Key::ELastCached::INT;
+		}
+		else if (kv_parse_double(k.value, d)) {
+			k.cachedv.fval = d;
+			k.cached = Key::ELastCached::FLOAT;
+		}
+		else if (strcasecmp(k.value, "true") == 0) {
+			k.cachedv.bval = true;
+			k.cached = Key::ELastCached::BOOL;
+		}
+		else if (strcasecmp(k.value, "false") == 0) {
+			k.cachedv.bval = false;
+			k.cached = Key::ELastCached::BOOL;
+		}
+	}
+	for (auto *section : this->child_sections)
+		section->PrecacheValues();
+}
+
+void KeyValues::Freeze() {
+	PrecacheValues();
+	FreezeInternal();
+}
+
+void KeyValues::FreezeInternal() {
+	/* Front-load everything FindKey/GetChild would otherwise build lazily on first use */
+	RefreshKeyHashes();
+	if (keys.size() > INDEX_BUILD_THRESHOLD || child_sections.size() > INDEX_BUILD_THRESHOLD)
+		BuildIndex();
+	m_frozen = true;
+	for (auto section : child_sections)
+		section->FreezeInternal();
+}
+
 KeyValues *KeyValues::GetChild(const char *name) {
+	if (m_childIndex.empty() && child_sections.size() > INDEX_BUILD_THRESHOLD)
+		BuildIndex();
+
+	if (!m_childIndex.empty()) {
+		int32_t i = IndexLookup(m_childIndex, true, name);
+		return i >= 0 ? child_sections[i] : nullptr;
+	}
+
 	for (auto _child : this->child_sections) {
 		if (_child->name && strcmp(name, _child->name) == 0) {
 			return _child;
@@ -636,55 +2833,86 @@ KeyValues *KeyValues::GetChild(const char *name) {
 }
 
 void KeyValues::SetBool(const char *key, bool v) {
-	for (auto &_key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			_key.cached = Key::ELastCached::BOOL;
-			_key.cachedv.bval = v;
-			return;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		_key->cached = Key::ELastCached::BOOL;
+		_key->cachedv.bval = v;
 	}
 }
 
 void KeyValues::SetInt(const char *key, int v) {
-	for (auto &_key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			_key.cached = Key::ELastCached::INT;
-			_key.cachedv.ival = v;
-			return;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		_key->cached = Key::ELastCached::INT;
+		_key->cachedv.ival = v;
 	}
 }
 
 void KeyValues::SetFloat(const char *key, float v) {
-	for (auto &_key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			_key.cached = Key::ELastCached::FLOAT;
-			_key.cachedv.fval = v;
-			return;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		_key->cached = Key::ELastCached::FLOAT;
+		_key->cachedv.fval = v;
 	}
 }
 
 void KeyValues::SetString(const char *key, const char *v) {
-	for (auto &_key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			_key.cached = Key::ELastCached::NONE;
-			if (_key.value)
-				kvfree(_key.value);
-			_key.value = kvstrdup(v);
-			return;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		_key->cached = Key::ELastCached::NONE;
+		if (_key->value && (!m_insitu || _key->ownedValue))
+			kvfree(_key->value);
+		_key->value = kvstrdup(v);
+		_key->ownedValue = m_insitu;
+	}
+}
+
+void KeyValues::SetStringOwned(const char *key, char *v) {
+	Key *_key = FindKey(key);
+	if (_key) {
+		_key->cached = Key::ELastCached::NONE;
+		if (_key->value && (!m_insitu || _key->ownedValue))
+			kvfree(_key->value);
+		_key->value = v;
+		_key->ownedValue = m_insitu;
 	}
+	else
+		kvfree(v);
+}
+
+KeyValues::Key &KeyValues::AddKey(const char *key, const char *value) {
+	Key &k = AppendKeyInternal(key);
+	k.value = kvstrdup(value ? value : "");
+	return k;
+}
+
+KeyValues::Key &KeyValues::AddKeyOwned(char *key, char *value) {
+	Key &k = AppendKeyOwnedInternal(key);
+	k.value = value;
+	return k;
+}
+
+KeyValues *KeyValues::AddChild(const char *name) {
+	KeyValues *kv = NewChild(name);
+	AppendChildInternal(kv);
+	return kv;
+}
+
+void KeyValues::Reserve(size_t numKeys, size_t numChildren) {
+	keys.reserve(numKeys);
+	m_keyHashes.reserve(numKeys);
+	if (numChildren)
+		child_sections.reserve(numChildren);
 }
 
 void KeyValues::ClearKey(const char *key) {
-	for (auto &_key : this->keys) {
-		if (_key.key && strcmp(_key.key, key) == 0) {
-			kvfree(_key.value);
-			_key.value = kvstrdup("");
-			_key.cached = Key::ELastCached::NONE;
-			return;
-		}
+	Key *_key = FindKey(key);
+	if (_key) {
+		if (_key->value && (!m_insitu || _key->ownedValue))
+			kvfree(_key->value);
+		_key->value = kvstrdup("");
+		_key->ownedValue = m_insitu;
+		_key->cached = Key::ELastCached::NONE;
 	}
 }
 
@@ -692,6 +2920,9 @@ void KeyValues::RemoveKey(const char *key) {
 	for (auto it = this->keys.begin(); it != this->keys.end(); it++) {
 		if (it->value && strcmp(key, it->value) == 0) {
 			this->keys.erase(it);
+			/* Slots shifted; the index and hash array must be rebuilt on next lookup */
+			m_keyIndex.clear();
+			m_keyHashes.clear();
 			return;
 		}
 	}
@@ -701,4 +2932,186 @@ void KeyValues::SetErrorCallback(KeyValues::pfnErrorCallback_t callback) {
 	this->pCallback = callback;
 }
 
+KeyValues::Key &KeyValues::AppendKeyInternal(const char *key) {
+	return AppendKeyOwnedInternal(kvstrdup(key));
+}
+
+KeyValues::Key &KeyValues::AppendKeyOwnedInternal(char *key) {
+	Key k;
+	k.key = key;
+	k.value = nullptr;
+	k.quoted = false;
+	keys.push_back(k);
+
+	if (m_keyHashes.size() == keys.size() - 1)
+		m_keyHashes.push_back(HashString(key));
+
+	if (!m_keyIndex.empty()) {
+		/* Rebuild once the table gets too loaded, otherwise slot the new entry in */
+		if (keys.size() * 2 > m_keyIndex.size())
+			BuildIndex();
+		else
+			IndexInsert(m_keyIndex, false, (int32_t)keys.size() - 1);
+	}
+	return keys.back();
+}
+
+void KeyValues::AppendChildInternal(KeyValues *child) {
+	child_sections.push_back(child);
+
+	if (!m_childIndex.empty()) {
+		if (child_sections.size() * 2 > m_childIndex.size())
+			BuildIndex();
+		else
+			IndexInsert(m_childIndex, true, (int32_t)child_sections.size() - 1);
+	}
+}
+
+KeyValues *KeyValues::DeepCopy() const {
+	auto *kv = new KeyValues();
+	if (name)
+		kv->name = kv->kvstrdup(name);
+	kv->quoted = quoted;
+	kv->good = good;
+	kv->m_pool = m_pool;
+
+	kv->keys.reserve(keys.size());
+	for (auto &k : keys) {
+		Key nk = k;
+		/* Pooled key strings are shared, not duplicated */
+		nk.key = k.keyId ? k.key : (k.key ? kv->kvstrdup(k.key) : nullptr);
+		nk.value = k.value ? kv->kvstrdup(k.value) : nullptr;
+		nk.ownedValue = false; /* The copy's strings follow the copy's ownership mode */
+		kv->keys.push_back(nk);
+	}
+
+	kv->child_sections.reserve(child_sections.size());
+	for (auto section : child_sections)
+		kv->child_sections.push_back(section->DeepCopy());
+	return kv;
+}
+
+size_t KeyValues::CloneStringBytes() const {
+	size_t n = name ? strlen(name) + 1 : 0;
+	for (auto &k : keys) {
+		if (k.key && !k.keyId)
+			n += strlen(k.key) + 1;
+		if (k.value)
+			n += strlen(k.value) + 1;
+	}
+	for (auto section : child_sections)
+		n += section->CloneStringBytes();
+	return n;
+}
+
+void KeyValues::CloneInto(KeyValues *dst, char *&cursor) const {
+	auto put = [&cursor](const char *s) -> char * {
+		if (!s)
+			return nullptr;
+		size_t len = strlen(s) + 1;
+		memcpy(cursor, s, len);
+		char *r = cursor;
+		cursor += len;
+		return r;
+	};
+
+	dst->name = put(name);
+	dst->quoted = quoted;
+	dst->good = good;
+	dst->m_pool = m_pool;
+	/* Strings live in the shared bulk block; nodes must not free them individually */
+	dst->m_insitu = true;
+
+	dst->keys.reserve(keys.size());
+	for (auto &k : keys) {
+		Key nk = k;
+		/* Pooled key strings are shared, not duplicated */
+		nk.key = k.keyId ? k.key : put(k.key);
+		nk.value = put(k.value);
+		nk.ownedValue = false; /* Cloned values live in the bulk block, not on the heap */
+		dst->keys.push_back(nk);
+	}
+
+	dst->child_sections.reserve(child_sections.size());
+	for (auto section : child_sections) {
+		auto *child = new KeyValues();
+		section->CloneInto(child, cursor);
+		dst->child_sections.push_back(child);
+	}
+}
+
+KeyValues *KeyValues::Clone() const {
+	size_t bytes = CloneStringBytes();
+	char *block = bytes ? (char *)malloc(bytes) : nullptr;
+	auto *kv = new KeyValues();
+	char *cursor = block;
+	CloneInto(kv, cursor);
+	kv->m_buffer = block; /* The root owns the bulk string block, like an adopted parse buffer */
+	return kv;
+}
+
+void KeyValues::MergeFrom(const KeyValues &overlay) {
+	for (auto &okey : overlay.keys) {
+		if (!okey.key)
+			continue;
+		Key *mine = FindKey(okey.key);
+		if (!mine)
+			mine = &AppendKeyInternal(okey.key);
+		if (mine->value && (!m_insitu || mine->ownedValue))
+			kvfree(mine->value);
+		mine->value = kvstrdup(okey.value ? okey.value : "");
+		mine->ownedValue = m_insitu;
+		mine->cached = okey.cached;
+		mine->cachedv = okey.cachedv;
+		mine->quoted = okey.quoted;
+	}
+
+	for (auto osec : overlay.child_sections) {
+		if (!osec->name)
+			continue;
+		KeyValues *mine = GetChild(osec->name);
+		if (mine)
+			mine->MergeFrom(*osec);
+		else
+			AppendChildInternal(osec->DeepCopy());
+	}
+}
+
+KeyValues *KeyValues::Diff(const KeyValues &newer) const {
+	/* FindKey/GetChild only mutate lazily-built caches, never the tree itself */
+	auto *self = const_cast<KeyValues *>(this);
+	auto *patch = new KeyValues();
+	if (newer.name)
+		patch->name = patch->kvstrdup(newer.name);
+	patch->quoted = newer.quoted;
+
+	for (auto &nkey : newer.keys) {
+		if (!nkey.key)
+			continue;
+		Key *mine = self->FindKey(nkey.key);
+		const char *nval = nkey.value ? nkey.value : "";
+		if (mine && strcmp(mine->value ? mine->value : "", nval) == 0)
+			continue;
+		Key &pkey = patch->AppendKeyInternal(nkey.key);
+		pkey.value = patch->kvstrdup(nval);
+		pkey.quoted = nkey.quoted;
+	}
+
+	for (auto nsec : newer.child_sections) {
+		if (!nsec->name)
+			continue;
+		KeyValues *mine = self->GetChild(nsec->name);
+		if (!mine) {
+			patch->AppendChildInternal(nsec->DeepCopy());
+			continue;
+		}
+		KeyValues *sub = mine->Diff(*nsec);
+		if (sub->keys.empty() && sub->child_sections.empty())
+			delete sub;
+		else
+			patch->AppendChildInternal(sub);
+	}
+	return patch;
+}
+
 #endif //KEYVALUES_IMPLEMENTATION
\ No newline at end of file
@@ -0,0 +1,183 @@
+
+#pragma once
+
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+
+#include "bits/libmisc.hpp"
+
+namespace LIBMISC_NAMESPACE {
+
+	// Log-bucketed latency histogram for always-on instrumentation.
+	//
+	// Values (nanoseconds) land in power-of-two major buckets subdivided 2^SUB_BITS ways,
+	// HdrHistogram-style, so relative error is bounded at 2^-SUB_BITS (~6%) with a fixed
+	// 8KB of counters. Each recording thread writes its own shard — no sharing, no locks,
+	// a record is a bucket computation plus one relaxed increment — and readers merge the
+	// shards on demand for count/percentile/max queries.
+	//
+	// Shards live until the histogram is destroyed. Intended for long-lived (typically
+	// static) histograms: per-thread shard caches are keyed by instance address, so
+	// destroy one only after every thread that recorded into it has stopped doing so.
+	class latency_histogram {
+	public:
+		static constexpr int SUB_BITS = 4;
+		static constexpr int SUB_COUNT = 1 << SUB_BITS;
+		static constexpr int NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+		latency_histogram() = default;
+		latency_histogram(const latency_histogram&) = delete;
+		latency_histogram& operator=(const latency_histogram&) = delete;
+
+		~latency_histogram() {
+			shard* s = m_shards.load(std::memory_order_acquire);
+			while (s) {
+				shard* next = s->next;
+				delete s;
+				s = next;
+			}
+		}
+
+		// Records one sample; safe to call from any number of threads concurrently
+		inline void record_ns(std::uint64_t ns) {
+			shard* s = get_shard();
+			s->counts[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+			if (ns > s->max.load(std::memory_order_relaxed))
+				s->max.store(ns, std::memory_order_relaxed); // Single writer per shard
+		}
+
+		inline void record(std::chrono::nanoseconds dur) {
+			record_ns(dur.count() > 0 ? (std::uint64_t)dur.count() : 0);
+		}
+
+		// Total recorded samples across all threads
+		std::uint64_t count() const {
+			std::uint64_t total = 0;
+			for (shard* s = m_shards.load(std::memory_order_acquire); s; s = s->next)
+				for (int i = 0; i < NUM_BUCKETS; i++)
+					total += s->counts[i].load(std::memory_order_relaxed);
+			return total;
+		}
+
+		// Largest recorded sample, exact
+		std::uint64_t max() const {
+			std::uint64_t m = 0;
+			for (shard* s = m_shards.load(std::memory_order_acquire); s; s = s->next) {
+				std::uint64_t v = s->max.load(std::memory_order_relaxed);
+				if (v > m)
+					m = v;
+			}
+			return m;
+		}
+
+		// Value at quantile q in [0,1], upper-bounded by the bucket edge (so within the
+		// bucket's relative error of the true quantile). 0 when empty
+		std::uint64_t percentile(double q) const {
+			std::uint64_t merged[NUM_BUCKETS] = {};
+			std::uint64_t total = 0;
+			for (shard* s = m_shards.load(std::memory_order_acquire); s; s = s->next) {
+				for (int i = 0; i < NUM_BUCKETS; i++) {
+					std::uint64_t c = s->counts[i].load(std::memory_order_relaxed);
+					merged[i] += c;
+					total += c;
+				}
+			}
+			if (!total)
+				return 0;
+			std::uint64_t target = (std::uint64_t)(q * (double)total);
+			if (target >= total)
+				target = total - 1;
+			std::uint64_t seen = 0;
+			for (int i = 0; i < NUM_BUCKETS; i++) {
+				seen += merged[i];
+				if (seen > target)
+					return bucket_upper(i);
+			}
+			return bucket_upper(NUM_BUCKETS - 1);
+		}
+
+		inline std::uint64_t p50() const {
+			return percentile(0.50);
+		}
+		inline std::uint64_t p95() const {
+			return percentile(0.95);
+		}
+		inline std::uint64_t p99() const {
+			return percentile(0.99);
+		}
+
+	private:
+		struct shard {
+			std::atomic<std::uint64_t> counts[NUM_BUCKETS] = {};
+			std::atomic<std::uint64_t> max { 0 };
+			shard* next = nullptr;
+		};
+
+		static inline int highest_bit(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+			return 63 - __builtin_clzll(v | 1);
+#else
+			int b = 0;
+			v |= 1;
+			while (v >>= 1)
+				b++;
+			return b;
+#endif
+		}
+
+		// Values below 2^SUB_BITS map exactly; above, the top SUB_BITS bits after the
+		// leading one pick the sub-bucket within the octave
+		static inline int bucket_index(std::uint64_t v) {
+			int msb = highest_bit(v);
+			if (msb < SUB_BITS)
+				return (int)v;
+			return (int)(((std::uint64_t)(msb - SUB_BITS + 1) << SUB_BITS) +
+						 ((v >> (msb - SUB_BITS)) & (SUB_COUNT - 1)));
+		}
+
+		// Inclusive upper edge of a bucket
+		static inline std::uint64_t bucket_upper(int idx) {
+			int major = idx >> SUB_BITS;
+			int sub = idx & (SUB_COUNT - 1);
+			if (major == 0)
+				return (std::uint64_t)idx;
+			int msb = major + SUB_BITS - 1;
+			std::uint64_t lower = ((std::uint64_t)1 << msb) + ((std::uint64_t)sub << (msb - SUB_BITS));
+			return lower + (((std::uint64_t)1 << (msb - SUB_BITS)) - 1);
+		}
+
+		// Finds or creates the calling thread's shard for this histogram. A small
+		// per-thread cache keyed by instance keeps the hot path to a pointer compare
+		shard* get_shard() {
+			struct tl_entry {
+				const latency_histogram* owner;
+				shard* s;
+			};
+			static thread_local tl_entry cache[8] = {};
+			static thread_local int evict = 0;
+
+			int free_slot = -1;
+			for (int i = 0; i < 8; i++) {
+				if (cache[i].owner == this)
+					return cache[i].s;
+				if (!cache[i].owner && free_slot < 0)
+					free_slot = i;
+			}
+
+			shard* s = new shard();
+			shard* head = m_shards.load(std::memory_order_relaxed);
+			do {
+				s->next = head;
+			} while (!m_shards.compare_exchange_weak(head, s, std::memory_order_release, std::memory_order_relaxed));
+
+			int slot = free_slot >= 0 ? free_slot : (evict++ & 7);
+			cache[slot].owner = this;
+			cache[slot].s = s;
+			return s;
+		}
+
+		std::atomic<shard*> m_shards { nullptr };
+	};
+
+}
@@ -0,0 +1,151 @@
+
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+
+#include "bits/libmisc.hpp"
+
+namespace LIBMISC_NAMESPACE {
+
+	// Thread-local tree of named profiling zones, filled in by scoped_timer below.
+	// Zone slots are preallocated and names are interned by pointer, so entering and
+	// leaving a zone is two TimerT::now() calls and a few stores — no allocation.
+	template<class TimerT = std::chrono::high_resolution_clock>
+	class zone_tree {
+	public:
+		static constexpr int MAX_ZONES = 256;
+
+		struct zone {
+			const char* name;
+			int parent;
+			int first_child;
+			int next_sibling;
+			std::uint64_t calls;
+			double total; // Seconds
+			double min;
+			double max;
+		};
+
+		// Per-thread instance
+		static zone_tree& instance() {
+			thread_local zone_tree inst;
+			return inst;
+		}
+
+		// Finds or creates the child of the current zone with this name and makes it
+		// current. Names are matched by pointer first (pass string literals); strcmp is
+		// the fallback so equal names from different TUs still share a zone.
+		// Returns -1 when out of slots; the sample is dropped.
+		int enter(const char* name) {
+			for (int c = m_zones[m_current].first_child; c != -1; c = m_zones[c].next_sibling) {
+				if (m_zones[c].name == name || !std::strcmp(m_zones[c].name, name)) {
+					m_current = c;
+					return c;
+				}
+			}
+			if (m_numZones >= MAX_ZONES)
+				return -1;
+			int idx = m_numZones++;
+			zone& z = m_zones[idx];
+			z.name = name;
+			z.parent = m_current;
+			z.first_child = -1;
+			z.next_sibling = m_zones[m_current].first_child;
+			m_zones[m_current].first_child = idx;
+			z.calls = 0;
+			z.total = 0;
+			z.min = 1e300;
+			z.max = 0;
+			m_current = idx;
+			return idx;
+		}
+
+		void leave(int idx, double seconds) {
+			if (idx < 0)
+				return;
+			zone& z = m_zones[idx];
+			z.calls++;
+			z.total += seconds;
+			if (seconds < z.min)
+				z.min = seconds;
+			if (seconds > z.max)
+				z.max = seconds;
+			m_current = z.parent;
+		}
+
+		// Looks a zone up by name anywhere in the tree
+		const zone* find(const char* name) const {
+			for (int i = 1; i < m_numZones; i++) {
+				if (m_zones[i].name == name || !std::strcmp(m_zones[i].name, name))
+					return &m_zones[i];
+			}
+			return nullptr;
+		}
+
+		// Dumps the zone tree with per-zone call counts and timings
+		void report(std::ostream& stream = std::cout) const {
+			for (int c = m_zones[0].first_child; c != -1; c = m_zones[c].next_sibling)
+				report_zone(c, 0, stream);
+		}
+
+		// Drops all recorded zones; outstanding scoped_timers must not exist
+		void reset() {
+			m_numZones = 1;
+			m_current = 0;
+			m_zones[0].first_child = -1;
+		}
+
+	private:
+		zone_tree() {
+			m_zones[0].name = "<root>";
+			m_zones[0].parent = -1;
+			m_zones[0].first_child = -1;
+			m_zones[0].next_sibling = -1;
+			m_numZones = 1;
+			m_current = 0;
+		}
+
+		void report_zone(int idx, int depth, std::ostream& stream) const {
+			const zone& z = m_zones[idx];
+			for (int i = 0; i < depth; i++)
+				stream << "  ";
+			stream << z.name << ": " << z.calls << " calls, " << z.total * 1e3 << " ms total, "
+				   << (z.calls ? z.total / z.calls : 0) * 1e6 << " us avg, " << z.min * 1e6 << " us min, "
+				   << z.max * 1e6 << " us max" << std::endl;
+			for (int c = z.first_child; c != -1; c = m_zones[c].next_sibling)
+				report_zone(c, depth + 1, stream);
+		}
+
+		zone m_zones[MAX_ZONES];
+		int m_numZones;
+		int m_current;
+	};
+
+	// RAII zone sample; nests naturally with scope, recording into the calling thread's
+	// zone_tree under whatever zone is currently open there
+	template<class TimerT = std::chrono::high_resolution_clock>
+	class scoped_timer {
+	public:
+		scoped_timer(const char* name) {
+			m_zone = zone_tree<TimerT>::instance().enter(name);
+			m_start = TimerT::now();
+		}
+
+		~scoped_timer() {
+			auto now = TimerT::now();
+			std::chrono::duration<double> dur = now - m_start;
+			zone_tree<TimerT>::instance().leave(m_zone, dur.count());
+		}
+
+		scoped_timer(const scoped_timer&) = delete;
+		scoped_timer& operator=(const scoped_timer&) = delete;
+
+	private:
+		std::chrono::time_point<TimerT> m_start;
+		int m_zone;
+	};
+
+}
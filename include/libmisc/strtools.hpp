@@ -6,6 +6,36 @@
 #include <cstdint>
 #include <cstddef>
 #include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+
+/* Vector kernels: SSE2 on x86 (baseline for x86_64), NEON on AArch64, scalar loops
+ * elsewhere. Define LIBMISC_NO_SIMD to force the scalar paths.
+ *
+ * The block loops read up to 15 bytes past the terminator — never across a page boundary
+ * (see detail::block_safe), but still past the string object, which AddressSanitizer
+ * rightly reports. These functions take bare C strings with no length to bound the loads
+ * against, so sanitized builds always take the scalar paths instead */
+#if !defined(LIBMISC_NO_SIMD)
+#if defined(__SANITIZE_ADDRESS__)
+#define LIBMISC_NO_SIMD 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define LIBMISC_NO_SIMD 1
+#endif
+#endif
+#endif
+
+#ifndef LIBMISC_NO_SIMD
+#if defined(__SSE2__) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIBMISC_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define LIBMISC_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
 
 namespace LIBMISC_NAMESPACE {
 
@@ -21,4 +51,274 @@ namespace LIBMISC_NAMESPACE {
 		return std::strncat(buf, src, N);
 	}
 
+	// Bounded copy that reports the number of chars written (excluding the terminator),
+	// so callers don't have to re-strlen the destination. Truncates like the strcpy
+	// wrapper above
+	template<size_t N>
+	size_t strcpy_len(char(&buf)[N], const char* src) {
+		size_t len = std::strlen(src);
+		if (len >= N)
+			len = N - 1;
+		std::memcpy(buf, src, len);
+		buf[len] = 0;
+		return len;
+	}
+
+#if defined(LIBMISC_SIMD_SSE2) || defined(LIBMISC_SIMD_NEON)
+	namespace detail {
+		// Unaligned 16-byte loads never fault as long as they don't cross into an
+		// unmapped page; true when the next 16 bytes sit within s's page
+		inline bool block_safe(const char* s) {
+			return ((std::uintptr_t)s & 0xFFF) <= 0xFF0;
+		}
+	}
+#endif
+
+	// Locale-free base-10 integer parse. Requires the whole string to be a number
+	// (optional sign, digits, nothing else); rejects overflow. Unlike strtol there is no
+	// errno dance and trailing garbage is an error, not silently ignored
+	inline bool parse_int(const char* s, long& out) {
+		const char* p = s;
+		bool neg = false;
+		if (*p == '+' || *p == '-') {
+			neg = *p == '-';
+			p++;
+		}
+		if (*p < '0' || *p > '9')
+			return false;
+		unsigned long long acc = 0;
+		int digits = 0;
+		for (; *p >= '0' && *p <= '9'; p++) {
+			acc = acc * 10 + (unsigned)(*p - '0');
+			if (++digits > 19)
+				return false;
+		}
+		if (*p)
+			return false;
+		if (acc > (unsigned long long)LONG_MAX + (neg ? 1ull : 0ull))
+			return false;
+		if (!neg)
+			out = (long)acc;
+		else if (acc == 0)
+			out = 0;
+		else
+			out = -(long)(acc - 1) - 1; /* Avoids overflow negating LONG_MIN's magnitude */
+		return true;
+	}
+
+	namespace detail {
+		// strtod fallback for floats the fast path can't do exactly; full-consumption and
+		// range checks replace the usual caller-side errno inspection
+		inline bool parse_float_slow(const char* s, double& out) {
+			char* end = nullptr;
+			errno = 0;
+			double d = std::strtod(s, &end);
+			if (end == s || *end || errno == ERANGE)
+				return false;
+			out = d;
+			return true;
+		}
+	}
+
+	// Locale-free decimal float parse. Mantissas up to 19 digits with decimal exponents
+	// within ±22 take the fast path — integer accumulation times an exact power of ten,
+	// which rounds identically to a full parse — everything else (hex floats, inf/nan,
+	// extreme exponents) falls back to strtod. Trailing garbage is an error
+	inline bool parse_float(const char* s, double& out) {
+		static constexpr double pow10tab[] = { 1e0,	 1e1,  1e2,	 1e3,  1e4,	 1e5,  1e6,	 1e7,
+											   1e8,	 1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+											   1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		const char* p = s;
+		bool neg = false;
+		if (*p == '+' || *p == '-') {
+			neg = *p == '-';
+			p++;
+		}
+
+		std::uint64_t mant = 0;
+		int digits = 0;
+		int frac = 0;
+		bool any = false;
+		for (; *p >= '0' && *p <= '9'; p++) {
+			mant = mant * 10 + (unsigned)(*p - '0');
+			digits++;
+			any = true;
+		}
+		if (*p == '.') {
+			p++;
+			for (; *p >= '0' && *p <= '9'; p++) {
+				mant = mant * 10 + (unsigned)(*p - '0');
+				digits++;
+				frac++;
+				any = true;
+			}
+		}
+		if (!any || digits > 19)
+			return detail::parse_float_slow(s, out); /* inf/nan/hex or too many digits */
+
+		int exp10 = 0;
+		if (*p == 'e' || *p == 'E') {
+			p++;
+			bool eneg = false;
+			if (*p == '+' || *p == '-') {
+				eneg = *p == '-';
+				p++;
+			}
+			if (*p < '0' || *p > '9')
+				return false;
+			for (; *p >= '0' && *p <= '9'; p++) {
+				exp10 = exp10 * 10 + (*p - '0');
+				if (exp10 > 9999)
+					return detail::parse_float_slow(s, out);
+			}
+			if (eneg)
+				exp10 = -exp10;
+		}
+		if (*p)
+			return false;
+
+		exp10 -= frac;
+		if ((mant >> 53) || exp10 < -22 || exp10 > 22)
+			return detail::parse_float_slow(s, out);
+
+		double d = (double)mant;
+		d = exp10 < 0 ? d / pow10tab[-exp10] : d * pow10tab[exp10];
+		out = neg ? -d : d;
+		return true;
+	}
+
+	// Case-insensitive compare with strcasecmp semantics, without the locale machinery.
+	// Runs 16 bytes at a time while both pointers stay clear of a page edge
+	inline int strcasecmp(const char* a, const char* b) {
+#ifdef LIBMISC_SIMD_SSE2
+		const __m128i ca = _mm_set1_epi8('A' - 1);
+		const __m128i cz = _mm_set1_epi8('Z' + 1);
+		const __m128i bit = _mm_set1_epi8(0x20);
+		const __m128i zero = _mm_setzero_si128();
+		while (detail::block_safe(a) && detail::block_safe(b)) {
+			__m128i va = _mm_loadu_si128((const __m128i*)a);
+			__m128i vb = _mm_loadu_si128((const __m128i*)b);
+			/* Lowercase both: add 0x20 where the byte is in A-Z */
+			__m128i ua = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi8(va, ca), _mm_cmplt_epi8(va, cz)), bit);
+			__m128i ub = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi8(vb, ca), _mm_cmplt_epi8(vb, cz)), bit);
+			__m128i la = _mm_add_epi8(va, ua);
+			__m128i lb = _mm_add_epi8(vb, ub);
+			int eq = _mm_movemask_epi8(_mm_cmpeq_epi8(la, lb));
+			int nul = _mm_movemask_epi8(_mm_cmpeq_epi8(va, zero));
+			if (eq != 0xFFFF)
+				break; /* Differ somewhere in this block; let the scalar loop report it */
+			if (nul)
+				return 0; /* Equal through the terminator */
+			a += 16;
+			b += 16;
+		}
+#elif defined(LIBMISC_SIMD_NEON)
+		const uint8x16_t ca = vdupq_n_u8('A');
+		const uint8x16_t cz = vdupq_n_u8('Z');
+		const uint8x16_t bit = vdupq_n_u8(0x20);
+		while (detail::block_safe(a) && detail::block_safe(b)) {
+			uint8x16_t va = vld1q_u8((const uint8_t*)a);
+			uint8x16_t vb = vld1q_u8((const uint8_t*)b);
+			uint8x16_t ua = vandq_u8(vandq_u8(vcgeq_u8(va, ca), vcleq_u8(va, cz)), bit);
+			uint8x16_t ub = vandq_u8(vandq_u8(vcgeq_u8(vb, ca), vcleq_u8(vb, cz)), bit);
+			uint8x16_t la = vaddq_u8(va, ua);
+			uint8x16_t lb = vaddq_u8(vb, ub);
+			if (vminvq_u8(vceqq_u8(la, lb)) != 0xFF)
+				break;
+			if (vmaxvq_u8(vceqq_u8(va, vdupq_n_u8(0))))
+				return 0;
+			a += 16;
+			b += 16;
+		}
+#endif
+		for (;; a++, b++) {
+			int la = (unsigned char)*a;
+			int lb = (unsigned char)*b;
+			if (la >= 'A' && la <= 'Z')
+				la += 0x20;
+			if (lb >= 'A' && lb <= 'Z')
+				lb += 0x20;
+			if (la != lb)
+				return la - lb;
+			if (!la)
+				return 0;
+		}
+	}
+
+	inline bool strcaseeq(const char* a, const char* b) {
+		return strcasecmp(a, b) == 0;
+	}
+
+	// Returns a pointer to the first char of s present in set, or nullptr if the string
+	// ends first. Scans 16 bytes per step; set is expected to be small (delimiters)
+	inline const char* find_first_of(const char* s, const char* set) {
+		size_t setlen = std::strlen(set);
+#ifdef LIBMISC_SIMD_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		while (detail::block_safe(s)) {
+			__m128i v = _mm_loadu_si128((const __m128i*)s);
+			__m128i hit = _mm_cmpeq_epi8(v, zero);
+			for (size_t k = 0; k < setlen; k++)
+				hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8(set[k])));
+			int mask = _mm_movemask_epi8(hit);
+			if (mask)
+				break; /* Terminator or match in this block; pinpoint it below */
+			s += 16;
+		}
+#elif defined(LIBMISC_SIMD_NEON)
+		while (detail::block_safe(s)) {
+			uint8x16_t v = vld1q_u8((const uint8_t*)s);
+			uint8x16_t hit = vceqq_u8(v, vdupq_n_u8(0));
+			for (size_t k = 0; k < setlen; k++)
+				hit = vorrq_u8(hit, vceqq_u8(v, vdupq_n_u8(set[k])));
+			if (vmaxvq_u8(hit))
+				break;
+			s += 16;
+		}
+#endif
+		for (; *s; s++) {
+			for (size_t k = 0; k < setlen; k++) {
+				if (*s == set[k])
+					return s;
+			}
+		}
+		return nullptr;
+	}
+
+	// Returns the first char of s that is not space/tab/newline/CR (possibly the
+	// terminator), 16 bytes per step
+	inline const char* skip_whitespace(const char* s) {
+#ifdef LIBMISC_SIMD_SSE2
+		const __m128i sp = _mm_set1_epi8(' ');
+		const __m128i tb = _mm_set1_epi8('\t');
+		const __m128i nl = _mm_set1_epi8('\n');
+		const __m128i cr = _mm_set1_epi8('\r');
+		while (detail::block_safe(s)) {
+			__m128i v = _mm_loadu_si128((const __m128i*)s);
+			__m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tb)),
+									  _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr)));
+			int mask = _mm_movemask_epi8(ws) ^ 0xFFFF;
+			if (mask)
+				break; /* Non-whitespace (or terminator) in this block */
+			s += 16;
+		}
+#elif defined(LIBMISC_SIMD_NEON)
+		const uint8x16_t sp = vdupq_n_u8(' ');
+		const uint8x16_t tb = vdupq_n_u8('\t');
+		const uint8x16_t nl = vdupq_n_u8('\n');
+		const uint8x16_t cr = vdupq_n_u8('\r');
+		while (detail::block_safe(s)) {
+			uint8x16_t v = vld1q_u8((const uint8_t*)s);
+			uint8x16_t ws = vorrq_u8(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, tb)),
+									 vorrq_u8(vceqq_u8(v, nl), vceqq_u8(v, cr)));
+			if (vminvq_u8(ws) != 0xFF)
+				break;
+			s += 16;
+		}
+#endif
+		for (; *s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'; s++)
+			;
+		return s;
+	}
+
 }
@@ -0,0 +1,89 @@
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "bits/libmisc.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#define LIBMISC_TSC_X86 1
+#elif defined(__aarch64__)
+#define LIBMISC_TSC_ARM64 1
+#endif
+
+namespace LIBMISC_NAMESPACE {
+
+	// Cycle-counter clock for timing tight loops, selectable as timer<tsc_clock>.
+	//
+	// A read is a serialized rdtsc (or cntvct_el0 on arm64) — a couple of ns versus the
+	// ~20ns clock_gettime behind high_resolution_clock. Ticks are converted to wall
+	// nanoseconds with a rate calibrated against steady_clock on first use. On x86 check
+	// invariant() before trusting long intervals: without invariant TSC the rate can
+	// drift with frequency scaling. Unknown architectures fall back to steady_clock.
+	struct tsc_clock {
+		using rep = std::int64_t;
+		using period = std::nano;
+		using duration = std::chrono::duration<rep, period>;
+		using time_point = std::chrono::time_point<tsc_clock, duration>;
+		static constexpr bool is_steady = true;
+
+		// Raw tick read, serialized so it cannot drift ahead of the work being timed
+		static inline std::uint64_t read() {
+#if defined(LIBMISC_TSC_X86)
+			std::uint32_t lo, hi;
+			__asm__ __volatile__("lfence\n\trdtsc" : "=a"(lo), "=d"(hi)::"memory");
+			return ((std::uint64_t)hi << 32) | lo;
+#elif defined(LIBMISC_TSC_ARM64)
+			std::uint64_t v;
+			__asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(v)::"memory");
+			return v;
+#else
+			return (std::uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+		}
+
+		static inline time_point now() {
+			return time_point(duration((rep)((double)read() * ns_per_tick())));
+		}
+
+		// True when the counter ticks at a constant rate regardless of power states
+		static inline bool invariant() {
+#if defined(LIBMISC_TSC_X86)
+			unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+			if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+				return false;
+			return (edx & (1u << 8)) != 0;
+#elif defined(LIBMISC_TSC_ARM64)
+			return true; // The generic timer is architecturally constant-rate
+#else
+			return true; // steady_clock fallback
+#endif
+		}
+
+		// Calibrated tick length; constant after first use
+		static inline double ns_per_tick() {
+			static double rate = calibrate();
+			return rate;
+		}
+
+	private:
+		// Measures the tick rate against steady_clock over a short busy-wait window
+		static inline double calibrate() {
+			using sc = std::chrono::steady_clock;
+			auto t0 = sc::now();
+			std::uint64_t c0 = read();
+			sc::time_point t1;
+			do {
+				t1 = sc::now();
+			} while (t1 - t0 < std::chrono::milliseconds(5));
+			std::uint64_t c1 = read();
+			if (c1 <= c0)
+				return 1.0;
+			double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+			return ns / (double)(c1 - c0);
+		}
+	};
+
+}
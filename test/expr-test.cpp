@@ -8,12 +8,26 @@ using namespace expr;
 static void test1();
 static void test2();
 static void test3();
+static void test4();
+static void test5();
+static void test6();
+static void test7();
+static void test8();
+static void test9();
+static void test10();
 
 int main(int argc, char**argv) {
 
 	test1();
 	test2();
 	test3();
+	test4();
+	test5();
+	test6();
+	test7();
+	test8();
+	test9();
+	test10();
 
 	return 0;
 }
@@ -46,6 +60,13 @@ static void test1() {
 		printf("Result was %s (expected true)\n", val ? "true" : "false");
 		assert(val == true);
 	}
+
+	{
+		/* A leading ')' must be rejected cleanly, not peek below the operator stack */
+		auto expr = BoolExpression<256>(")A");
+		expr.define("A", true);
+		assert(expr.parse() == expr::Error::UnmatchedClosingParenths);
+	}
 }
 
 static void test2() {
@@ -113,4 +134,309 @@ static void test3() {
 	}
 }
 
+static void test4() {
+
+	/* (A&B)|C over every assignment, checked against eval and ground truth */
+	{
+		auto expr = BoolExpression<256>("A&B|C");
+		expr.define("A", false);
+		expr.define("B", false);
+		expr.define("C", false);
+
+		assert(expr.parse() == expr::Error::OK);
+		assert(expr.compile() == expr::Error::OK);
+
+		bool matrix[8 * 3];
+		bool expected[8];
+		for (int i = 0; i < 8; i++) {
+			bool a = i & 1, b = i & 2, c = i & 4;
+			matrix[i * 3 + 0] = a;
+			matrix[i * 3 + 1] = b;
+			matrix[i * 3 + 2] = c;
+			expected[i] = (a && b) || c;
+		}
+
+		bool results[8];
+		assert(expr.evalMany(matrix, 3, results, 8) == expr::Error::OK);
+
+		for (int i = 0; i < 8; i++) {
+			assert(results[i] == expected[i]);
+
+			expr.set(0, matrix[i * 3 + 0]);
+			expr.set(1, matrix[i * 3 + 1]);
+			expr.set(2, matrix[i * 3 + 2]);
+			bool val = false;
+			assert(expr.eval(val) == expr::Error::OK);
+			assert(val == expected[i]);
+		}
+		printf("evalMany matched eval for all 8 assignments of A&B|C\n");
+	}
+}
+
+static void test5() {
+
+	/* Packed evaluation: every assignment of A^(B&!C) in one pass, lanes 0-7 */
+	{
+		auto expr = BoolExpression<256>("A^(B&!C)");
+		expr.define("A", false);
+		expr.define("B", false);
+		expr.define("C", false);
+
+		assert(expr.parse() == expr::Error::OK);
+
+		uint64_t varBits[BoolExpression<256>::PARAM_MAX] = {};
+		for (int i = 0; i < 8; i++) {
+			if (i & 1)
+				varBits[0] |= 1ull << i;
+			if (i & 2)
+				varBits[1] |= 1ull << i;
+			if (i & 4)
+				varBits[2] |= 1ull << i;
+		}
+
+		uint64_t resultBits = 0;
+		assert(expr.evalPacked(varBits, resultBits) == expr::Error::OK);
+
+		for (int i = 0; i < 8; i++) {
+			bool a = i & 1, b = i & 2, c = i & 4;
+			bool expected = a ^ (b && !c);
+			assert(((resultBits >> i) & 1) == (uint64_t)expected);
+		}
+		printf("evalPacked matched ground truth for all 8 assignments of A^(B&!C)\n");
+	}
+}
+
+static void test6() {
+
+	/* Well past the old 26-variable ceiling, with multi-char names */
+	{
+		std::string src;
+		for (int i = 0; i < 40; i++) {
+			char name[16];
+			snprintf(name, sizeof(name), "flag_%d", i);
+			if (i)
+				src += '|';
+			src += name;
+		}
+
+		auto expr = BoolExpression<512>(src);
+		for (int i = 0; i < 40; i++) {
+			char name[16];
+			snprintf(name, sizeof(name), "flag_%d", i);
+			assert(expr.define(name, false) == i);
+		}
+		/* Redefining must reuse the slot, not burn a new one */
+		assert(expr.define("flag_7", false) == 7);
+		assert(expr.numVars() == 40);
+
+		assert(expr.parse() == expr::Error::OK);
+
+		bool val = true;
+		assert(expr.eval(val) == expr::Error::OK);
+		assert(val == false);
+
+		expr.set(37, true);
+		assert(expr.eval(val) == expr::Error::OK);
+		assert(val == true);
+
+		expr.set(37, false);
+		expr.define("flag_0", true);
+		assert(expr.eval(val) == expr::Error::OK);
+		assert(val == true);
+
+		printf("40-variable expression evaluated correctly\n");
+	}
+}
+
+static void test7() {
+
+	/* Folding against known vars must prune dead subtrees and preserve results */
+	{
+		auto expr = BoolExpression<256>("(k0&X)|(k1&Y)|(k0^Z)");
+		expr.define("k0", false);
+		expr.define("k1", true);
+		expr.define("X", false);
+		expr.define("Y", false);
+		expr.define("Z", false);
+
+		assert(expr.parse() == expr::Error::OK);
+		int unfolded = expr.m_numOps;
+
+		/* k0/k1 fixed; X/Y/Z free. Folds to Y|Z */
+		bool known[5] = { false, true, false, false, false };
+		bool isKnown[5] = { true, true, false, false, false };
+		assert(expr.fold(known, isKnown) == expr::Error::OK);
+		assert(expr.m_numOps < unfolded);
+		assert(expr.m_numOps == 3);
+
+		for (int i = 0; i < 8; i++) {
+			bool x = i & 1, y = i & 2, z = i & 4;
+			expr.set(2, x);
+			expr.set(3, y);
+			expr.set(4, z);
+			bool val = false;
+			assert(expr.eval(val) == expr::Error::OK);
+			assert(val == ((false && x) || (true && y) || (false != z)));
+		}
+	}
+
+	/* A fully-known expression must collapse to a single constant */
+	{
+		auto expr = BoolExpression<256>("a&(b|!c)");
+		expr.define("a", true);
+		expr.define("b", false);
+		expr.define("c", false);
+
+		bool known[3] = { true, false, false };
+		bool isKnown[3] = { true, true, true };
+		assert(expr.fold(known, isKnown) == expr::Error::OK);
+		assert(expr.m_numOps == 1);
+
+		bool val = false;
+		assert(expr.eval(val) == expr::Error::OK);
+		assert(val == true);
+	}
+	printf("fold pruned known subtrees and preserved results\n");
+}
+
+/* Everything here happens at compile time; variable v lives in bit v of the mask (A=bit 0) */
+static constexpr StaticBoolExpression<> s_ab_or_c("A&B|C");
+static_assert(s_ab_or_c.good(), "literal must parse at compile time");
+static_assert(s_ab_or_c.eval(0b011) == true, "A&B");
+static_assert(s_ab_or_c.eval(0b001) == false, "A alone");
+static_assert(s_ab_or_c.eval(0b100) == true, "C alone");
+
+static constexpr StaticBoolExpression<> s_nested("!A&B|(C&D)");
+static_assert(s_nested.good(), "literal must parse at compile time");
+static_assert(s_nested.eval(0b1100) == true, "C&D");
+static_assert(s_nested.eval(0b0001) == false, "A only");
+
+static_assert(!StaticBoolExpression<>("A&").good(), "dangling op must be rejected");
+static_assert(!StaticBoolExpression<>("(A&B").good(), "unbalanced parens must be rejected");
+static_assert(!StaticBoolExpression<>("A$B").good(), "bad token must be rejected");
 
+static void test8() {
+
+	/* And the same object still works with runtime masks */
+	for (int i = 0; i < 8; i++) {
+		bool a = i & 1, b = i & 2, c = i & 4;
+		assert(s_ab_or_c.eval((std::uint32_t)i) == ((a && b) || c));
+	}
+	printf("StaticBoolExpression matched ground truth at compile and run time\n");
+}
+
+static void test9() {
+
+	/* Rules sharing predicates heavily; CSE must shrink the node count and results must
+	 * match standalone evaluation */
+	RuleSet<256> rules;
+	for (int i = 0; i < 8; i++) {
+		char name[8];
+		snprintf(name, sizeof(name), "p%d", i);
+		assert(rules.define(name) == i);
+	}
+
+	char exprs[64][64];
+	int numRules = 0;
+	for (int i = 0; i < 8; i++) {
+		/* Every rule shares the p0&p1 predicate; half share p2|p3 too */
+		if (i & 1)
+			snprintf(exprs[numRules], sizeof(exprs[0]), "(p0&p1)|(p2|p3)&p%d", i);
+		else
+			snprintf(exprs[numRules], sizeof(exprs[0]), "(p0&p1)^p%d", i);
+		expr::Error err;
+		assert(rules.addRule(exprs[numRules], &err) == numRules);
+		assert(err == expr::Error::OK);
+		numRules++;
+	}
+	assert((int)rules.numRules() == numRules);
+	assert((int)rules.numNodes() < rules.totalOps());
+
+	/* Bad expressions must be rejected without taking a slot */
+	expr::Error err;
+	assert(rules.addRule("p0&&", &err) == -1);
+	assert((int)rules.numRules() == numRules);
+
+	for (int mask = 0; mask < 256; mask += 37) {
+		bool vars[8];
+		for (int v = 0; v < 8; v++)
+			vars[v] = (mask >> v) & 1;
+
+		std::vector<bool> out;
+		assert(rules.evalAll(vars, out, 4) == expr::Error::OK);
+		assert((int)out.size() == numRules);
+
+		for (int r = 0; r < numRules; r++) {
+			auto single = BoolExpression<256>(exprs[r]);
+			for (int v = 0; v < 8; v++) {
+				char name[8];
+				snprintf(name, sizeof(name), "p%d", v);
+				single.define(name, vars[v]);
+			}
+			bool expected = false;
+			assert(single.parse() == expr::Error::OK);
+			assert(single.eval(expected) == expr::Error::OK);
+			assert(out[r] == expected);
+		}
+	}
+	printf("RuleSet evalAll matched standalone evaluation (%d ops -> %d nodes)\n", rules.totalOps(),
+		   (int)rules.numNodes());
+}
+
+static void test10() {
+
+	/* Incremental mode: after the first eval(), flipping one variable must give the same
+	 * answers as a full re-evaluation for every rule */
+	RuleSet<256> rules;
+	for (int i = 0; i < 8; i++) {
+		char name[8];
+		snprintf(name, sizeof(name), "p%d", i);
+		rules.define(name, false);
+	}
+
+	char exprs[16][64];
+	int numRules = 0;
+	for (int i = 0; i < 8; i++) {
+		if (i & 1)
+			snprintf(exprs[numRules], sizeof(exprs[0]), "(p0&p1)|(p2^p%d)", i);
+		else
+			snprintf(exprs[numRules], sizeof(exprs[0]), "!(p1|p3)&p%d", i);
+		assert(rules.addRule(exprs[numRules]) == numRules);
+		numRules++;
+	}
+
+	bool vars[8] = {};
+	auto check = [&]() {
+		std::vector<bool> full;
+		assert(rules.evalAll(vars, full, 1) == expr::Error::OK);
+		for (int r = 0; r < numRules; r++)
+			assert(rules.eval(r) == full[r]);
+	};
+	check(); /* First eval() primes the whole DAG */
+
+	/* One flag flip per "event", walking through every variable a few times */
+	for (int step = 0; step < 64; step++) {
+		int v = (step * 5) % 8;
+		vars[v] = !vars[v];
+		rules.set(v, vars[v]);
+		check();
+	}
+
+	/* Setting a variable no rule reads must be harmless */
+	int unused = rules.define("unused", false);
+	rules.set(unused, true);
+	check();
+
+	/* Adding a rule after eval() reprimes the incremental state */
+	int late = rules.addRule("p0&p7");
+	assert(late == numRules);
+	vars[0] = vars[7] = true;
+	rules.set(0, true);
+	rules.set(7, true);
+	assert(rules.eval(late));
+	vars[7] = false;
+	rules.set(7, false);
+	assert(!rules.eval(late));
+
+	printf("RuleSet incremental eval matched full re-evaluation across single-flag flips\n");
+}
@@ -0,0 +1,200 @@
+
+/*
+ * Benchmark harness for KeyValues and Expr.
+ *
+ * Generates parameterized corpora (wide/deep/quoted/escaped), runs each benchmark with
+ * warmup and median-of-N repetition, and reports throughput in CSV (default) or JSON
+ * (--json) so runs can be diffed across commits. Built with optimization regardless of
+ * the -O0 the test targets use; see libmisc_bench in CMakeLists.txt.
+ */
+
+#include "test_common.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#define KEYVALUES_IMPLEMENTATION
+#include "../code/KeyValues.hpp"
+#include "../code/Expr.hpp"
+
+static constexpr int REPS = 9;
+static constexpr int WARMUP = 2;
+
+struct result {
+	const char* name;
+	const char* metric; /* What the value measures */
+	double median_ms;
+	double value;
+	const char* unit;
+};
+
+static std::vector<result> s_results;
+
+/* Runs fn WARMUP+REPS times and returns the median duration in ms. libmisc::timer
+ * truncates to whole milliseconds, so time with chrono directly here */
+template <class Fn>
+static double median_ms(Fn&& fn) {
+	double samples[REPS];
+	for (int i = 0; i < WARMUP + REPS; i++) {
+		auto t0 = std::chrono::steady_clock::now();
+		fn();
+		auto t1 = std::chrono::steady_clock::now();
+		if (i >= WARMUP)
+			samples[i - WARMUP] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+	}
+	std::sort(samples, samples + REPS);
+	return samples[REPS / 2];
+}
+
+/*
+ * Corpus shapes. Sizes are chosen so each parse run is a few ms at -O2.
+ */
+
+static std::string corpus_wide(int numKeys) {
+	std::string s = "root\n{\n";
+	char line[96];
+	for (int i = 0; i < numKeys; i++) {
+		snprintf(line, sizeof(line), "\t\"key_%d\" \"value %d\"\n", i, i);
+		s += line;
+	}
+	s += "}\n";
+	return s;
+}
+
+static std::string corpus_deep(int depth, int keysPerLevel) {
+	std::string s;
+	char line[96];
+	for (int d = 0; d < depth; d++) {
+		snprintf(line, sizeof(line), "level_%d\n{\n", d);
+		s += line;
+		for (int k = 0; k < keysPerLevel; k++) {
+			snprintf(line, sizeof(line), "\t\"key_%d\" \"%d\"\n", k, k * d);
+			s += line;
+		}
+	}
+	for (int d = 0; d < depth; d++)
+		s += "}\n";
+	return s;
+}
+
+static std::string corpus_quoted(int numKeys) {
+	std::string s = "root\n{\n";
+	char line[128];
+	for (int i = 0; i < numKeys; i++) {
+		snprintf(line, sizeof(line), "\t\"key with spaces %d\" \"a longer quoted value, %d of them\"\n", i, i);
+		s += line;
+	}
+	s += "}\n";
+	return s;
+}
+
+static std::string corpus_escaped(int numKeys) {
+	std::string s = "root\n{\n";
+	char line[128];
+	for (int i = 0; i < numKeys; i++) {
+		snprintf(line, sizeof(line), "\t\"path_%d\" \"C:\\\\game\\\\assets\\\\model_%d.mdl\"\n", i, i);
+		s += line;
+	}
+	s += "}\n";
+	return s;
+}
+
+static void bench_parse(const char* name, const std::string& corpus) {
+	double ms = median_ms([&]() {
+		auto* kv = KeyValues::FromString(corpus.c_str());
+		assert(kv);
+		delete kv;
+	});
+	double mbps = ((double)corpus.size() / 1.0e6) / (ms / 1.0e3);
+	s_results.push_back({ name, "parse", ms, mbps, "MB/s" });
+}
+
+static void bench_getstring() {
+	constexpr int NUM_KEYS = 1000;
+	constexpr int LOOKUPS = 1000000;
+
+	std::string corpus = corpus_wide(NUM_KEYS);
+	auto* kv = KeyValues::FromString(corpus.c_str());
+	assert(kv);
+	auto* root = kv->GetChild("root");
+	assert(root);
+
+	char names[NUM_KEYS][16];
+	for (int i = 0; i < NUM_KEYS; i++)
+		snprintf(names[i], sizeof(names[i]), "key_%d", i);
+
+	volatile size_t sink = 0;
+	double ms = median_ms([&]() {
+		size_t acc = 0;
+		for (int i = 0; i < LOOKUPS; i++)
+			acc += (size_t)root->GetString(names[i % NUM_KEYS])[0];
+		sink = acc;
+	});
+	(void)sink;
+	s_results.push_back({ "getstring_1k", "lookup", ms, (double)LOOKUPS / (ms / 1.0e3), "ops/s" });
+	delete kv;
+}
+
+static void bench_expr_eval() {
+	constexpr int EVALS = 1000000;
+
+	expr::BoolExpression<256> e("(A&B)|(C&!D)^E");
+	e.define("A", true);
+	e.define("B", false);
+	e.define("C", true);
+	e.define("D", false);
+	e.define("E", true);
+	assert(e.parse() == expr::Error::OK);
+
+	volatile int sink = 0;
+	double ms = median_ms([&]() {
+		int acc = 0;
+		for (int i = 0; i < EVALS; i++) {
+			e.set(1, i & 1);
+			bool val = false;
+			e.eval(val);
+			acc += val;
+		}
+		sink = acc;
+	});
+	(void)sink;
+	s_results.push_back({ "expr_eval", "eval", ms, (double)EVALS / (ms / 1.0e3), "ops/s" });
+}
+
+static void report(bool json) {
+	if (json) {
+		printf("[\n");
+		for (size_t i = 0; i < s_results.size(); i++) {
+			const result& r = s_results[i];
+			printf("  {\"name\": \"%s\", \"metric\": \"%s\", \"median_ms\": %.4f, \"value\": %.1f, "
+				   "\"unit\": \"%s\"}%s\n",
+				   r.name, r.metric, r.median_ms, r.value, r.unit, i + 1 < s_results.size() ? "," : "");
+		}
+		printf("]\n");
+	}
+	else {
+		printf("name,metric,median_ms,value,unit\n");
+		for (const result& r : s_results)
+			printf("%s,%s,%.4f,%.1f,%s\n", r.name, r.metric, r.median_ms, r.value, r.unit);
+	}
+}
+
+int main(int argc, char** argv) {
+	bool json = false;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--json"))
+			json = true;
+	}
+
+	bench_parse("parse_wide_50k", corpus_wide(50000));
+	bench_parse("parse_deep_500x20", corpus_deep(500, 20));
+	bench_parse("parse_quoted_30k", corpus_quoted(30000));
+	bench_parse("parse_escaped_30k", corpus_escaped(30000));
+	bench_getstring();
+	bench_expr_eval();
+
+	report(json);
+	return 0;
+}
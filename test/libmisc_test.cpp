@@ -2,6 +2,10 @@
 #include "test_common.h"
 
 #include "../include/libmisc/timer.hpp"
+#include "../include/libmisc/profile.hpp"
+#include "../include/libmisc/tsc_clock.hpp"
+#include "../include/libmisc/histogram.hpp"
+#include "../include/libmisc/strtools.hpp"
 
 #include "time.h"
 #include "assert.h"
@@ -11,11 +15,778 @@
 #include "../code/KeyValues.hpp"
 
 static void kv_perftest1();
+static void kv_arenatest1();
+static void kv_insitutest1();
+static void kv_indextest1();
+static void kv_compiledtest1();
+static void kv_streamtest1();
+static void kv_loadfilestest1();
+static void kv_mergetest1();
+static void kv_dumpbuffertest1();
+static void kv_interntest1();
+static void profiletest1();
+static void tsctest1();
+static void histotest1();
+static void strtoolstest1();
+static void kv_numtest1();
+static void kv_pathtest1();
+static void kv_clonetest1();
+static void kv_buildtest1();
+static void kv_freezetest1();
 
 int main() {
+	kv_numtest1();
+	kv_pathtest1();
+	kv_clonetest1();
+	kv_buildtest1();
+	kv_freezetest1();
+	profiletest1();
+	tsctest1();
+	histotest1();
+	strtoolstest1();
+	kv_arenatest1();
+	kv_insitutest1();
+	kv_indextest1();
+	kv_compiledtest1();
+	kv_streamtest1();
+	kv_loadfilestest1();
+	kv_mergetest1();
+	kv_dumpbuffertest1();
+	kv_interntest1();
 	kv_perftest1();
 }
 
+static void profiletest1() {
+	T_TESTCASE();
+
+	for (int i = 0; i < 10; i++) {
+		libmisc::scoped_timer<> outer("outer");
+		for (int j = 0; j < 3; j++) {
+			libmisc::scoped_timer<> inner("inner");
+		}
+	}
+	{
+		/* A sibling at the top level, not under "outer" */
+		libmisc::scoped_timer<> other("other");
+	}
+
+	auto& tree = libmisc::zone_tree<>::instance();
+	auto* outer = tree.find("outer");
+	auto* inner = tree.find("inner");
+	auto* other = tree.find("other");
+	assert(outer && inner && other);
+	assert(outer->calls == 10);
+	assert(inner->calls == 30);
+	assert(other->calls == 1);
+	/* Nesting must be structural, not name-based */
+	assert(inner->parent != -1);
+	assert(strcmp(tree.find("outer")->name, "outer") == 0);
+	assert(outer->total >= inner->total); /* Outer scopes envelop their children */
+	assert(inner->min <= inner->max);
+
+	tree.report();
+	tree.reset();
+	assert(tree.find("outer") == nullptr);
+}
+
+static void tsctest1() {
+	T_TESTCASE();
+
+	/* Reads must be monotonic */
+	auto last = libmisc::tsc_clock::now();
+	for (int i = 0; i < 1000; i++) {
+		auto now = libmisc::tsc_clock::now();
+		assert(now >= last);
+		last = now;
+	}
+
+	/* And roughly agree with the system clock over a measurable window */
+	libmisc::timer<libmisc::tsc_clock> tsc_timer;
+	libmisc::timer<> std_timer;
+	tsc_timer.begin();
+	std_timer.begin();
+	auto t0 = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(20))
+		;
+	tsc_timer.end();
+	std_timer.end();
+
+	double tsc_ms = tsc_timer.get_ms();
+	double std_ms = std_timer.get_ms();
+	assert(tsc_ms > std_ms * 0.5 && tsc_ms < std_ms * 2.0);
+
+	printf("tsc: %.3f ms, std: %.3f ms, invariant: %d, %.4f ns/tick\n", tsc_ms, std_ms,
+		   libmisc::tsc_clock::invariant(), libmisc::tsc_clock::ns_per_tick());
+}
+
+static void histotest1() {
+	T_TESTCASE();
+
+	/* Uniform 0..9999; percentiles must land within the bucket error bound */
+	static libmisc::latency_histogram hist;
+	for (int i = 0; i < 10000; i++)
+		hist.record_ns(i);
+
+	assert(hist.count() == 10000);
+	assert(hist.max() == 9999);
+	assert(hist.p50() >= 5000 * 0.9 && hist.p50() <= 5000 * 1.1);
+	assert(hist.p95() >= 9500 * 0.9 && hist.p95() <= 9500 * 1.1);
+	assert(hist.p99() >= 9900 * 0.9 && hist.p99() <= 9900 * 1.1);
+
+	/* Tiny values map to exact buckets */
+	static libmisc::latency_histogram small;
+	small.record_ns(3);
+	small.record_ns(3);
+	small.record_ns(7);
+	assert(small.count() == 3);
+	assert(small.max() == 7);
+	assert(small.p50() == 3);
+
+	/* Concurrent recording from several threads must lose nothing */
+	static libmisc::latency_histogram shared;
+	std::thread workers[4];
+	for (int t = 0; t < 4; t++) {
+		workers[t] = std::thread([t]() {
+			for (int i = 0; i < 100000; i++)
+				shared.record_ns((std::uint64_t)(t + 1) * 100);
+		});
+	}
+	for (auto& w : workers)
+		w.join();
+	assert(shared.count() == 400000);
+	assert(shared.max() == 400);
+
+	printf("p50=%llu p95=%llu p99=%llu max=%llu\n", (unsigned long long)hist.p50(), (unsigned long long)hist.p95(),
+		   (unsigned long long)hist.p99(), (unsigned long long)hist.max());
+}
+
+static void strtoolstest1() {
+	T_TESTCASE();
+
+	/* Bounded copy reporting the length */
+	{
+		char buf[8];
+		assert(libmisc::strcpy_len(buf, "abc") == 3);
+		assert(strcmp(buf, "abc") == 0);
+		assert(libmisc::strcpy_len(buf, "0123456789") == 7); /* Truncated */
+		assert(strcmp(buf, "0123456") == 0);
+	}
+
+	/* Case-insensitive compare, long enough to exercise the vector path */
+	{
+		assert(libmisc::strcasecmp("TRUE", "true") == 0);
+		assert(libmisc::strcasecmp("True", "tRuE") == 0);
+		assert(libmisc::strcasecmp("true", "trud") > 0);
+		assert(libmisc::strcasecmp("abc", "abcd") < 0);
+		assert(libmisc::strcaseeq("The Quick Brown Fox Jumps Over The Lazy Dog",
+								  "the quick brown fox jumps over the lazy dog"));
+		assert(!libmisc::strcaseeq("The Quick Brown Fox Jumps Over The Lazy Dog",
+								   "the quick brown fox jumps over the lazy dot"));
+	}
+
+	/* Delimiter scan past the first block */
+	{
+		const char* s = "a_long_identifier_with_no_delims_until{here}";
+		const char* hit = libmisc::find_first_of(s, "{}\" ");
+		assert(hit && *hit == '{');
+		assert(hit - s == (long)strcspn(s, "{}\" "));
+		assert(libmisc::find_first_of("nothing_to_find", "{}") == nullptr);
+	}
+
+	/* Whitespace runs longer than one vector block */
+	{
+		char buf[64];
+		memset(buf, ' ', 40);
+		buf[17] = '\t';
+		buf[23] = '\n';
+		buf[40] = 'x';
+		buf[41] = 0;
+		assert(*libmisc::skip_whitespace(buf) == 'x');
+		assert(*libmisc::skip_whitespace("   \t\r\n") == 0);
+		assert(*libmisc::skip_whitespace("abc") == 'a');
+	}
+}
+
+static void kv_numtest1() {
+	T_TESTCASE();
+
+	/* The strtools parse routines */
+	{
+		long l = 0;
+		assert(libmisc::parse_int("12345", l) && l == 12345);
+		assert(libmisc::parse_int("-987", l) && l == -987);
+		assert(libmisc::parse_int("+42", l) && l == 42);
+		assert(!libmisc::parse_int("123abc", l)); /* strtol would silently accept this */
+		assert(!libmisc::parse_int("", l));
+		assert(!libmisc::parse_int("99999999999999999999999", l));
+
+		double d = 0;
+		assert(libmisc::parse_float("1.5", d) && d == 1.5);
+		assert(libmisc::parse_float("-0.25", d) && d == -0.25);
+		assert(libmisc::parse_float("6.25e2", d) && d == 625.0);
+		assert(libmisc::parse_float("1e-3", d) && d == 0.001);
+		assert(libmisc::parse_float("123456789.123456789", d) && d == 123456789.123456789);
+		assert(libmisc::parse_float("1.7976931348623157e308", d)); /* Slow path */
+		assert(!libmisc::parse_float("1.5x", d));
+		assert(!libmisc::parse_float("", d));
+	}
+
+	/* And the KeyValues cache-fill paths built on the same logic */
+	{
+		auto* kv = KeyValues::FromString(
+			"test\n{\n\t\"i\" \"-123\"\n\t\"f\" \"0.125\"\n\t\"e\" \"2.5e3\"\n\t\"bad\" \"12ab\"\n}\n");
+		assert(kv);
+		auto* test = kv->GetChild("test");
+		assert(test->GetInt("i") == -123);
+		assert(test->GetDouble("f") == 0.125);
+		assert(test->GetDouble("e") == 2500.0);
+		/* Partial numbers must fall back to the default instead of caching garbage */
+		assert(test->GetInt("bad", -1) == -1);
+		assert(test->GetInt("bad", -1) == -1); /* And stay failed on the second read */
+		/* A prior failure must not poison later conversions (the old errno bug) */
+		assert(test->GetInt("i") == -123);
+		delete kv;
+	}
+
+	/* Eager numeric conversion at parse time */
+	{
+		auto* kv = KeyValues::FromString(
+			"test\n{\n\t\"i\" \"77\"\n\t\"f\" \"2.5\"\n\t\"b\" \"true\"\n\t\"s\" \"hello\"\n}\n", false,
+			KeyValues::EAGER_NUMERIC);
+		assert(kv);
+		auto* test = kv->GetChild("test");
+		auto& keys = test->Keys();
+		assert(keys[0].cached == KeyValues::Key::ELastCached::INT && keys[0].cachedv.ival == 77);
+		assert(keys[1].cached == KeyValues::Key::ELastCached::FLOAT && keys[1].cachedv.fval == 2.5);
+		assert(keys[2].cached == KeyValues::Key::ELastCached::BOOL && keys[2].cachedv.bval == true);
+		assert(keys[3].cached == KeyValues::Key::ELastCached::NONE);
+		assert(test->GetInt("i") == 77);
+		assert(test->GetBool("b") == true);
+		delete kv;
+	}
+
+	/* And on-demand precache for an existing tree */
+	{
+		auto* kv = KeyValues::FromString("test\n{\n\tsub\n\t{\n\t\t\"n\" \"-5\"\n\t}\n}\n");
+		assert(kv);
+		kv->PrecacheValues();
+		auto& key = kv->GetChild("test")->GetChild("sub")->Keys()[0];
+		assert(key.cached == KeyValues::Key::ELastCached::INT && key.cachedv.ival == -5);
+		delete kv;
+	}
+}
+
+static void kv_pathtest1() {
+	T_TESTCASE();
+
+	auto* kv = KeyValues::FromString(
+		"weapons\n{\n\trifle\n\t{\n\t\t\"damage\" \"42\"\n\t\t\"name\" \"m4\"\n\t}\n"
+		"\tpistol\n\t{\n\t\t\"damage\" \"12\"\n\t}\n}\n");
+	assert(kv);
+
+	assert(kv->GetIntByPath("weapons/rifle/damage") == 42);
+	assert(kv->GetIntByPath("weapons/rifle/damage") == 42); /* Cached probe */
+	assert(kv->GetIntByPath("weapons/pistol/damage") == 12);
+	assert(strcmp(kv->GetStringByPath("weapons/rifle/name"), "m4") == 0);
+	assert(kv->GetIntByPath("weapons/shotgun/damage", -1) == -1);
+	assert(kv->GetIntByPath("weapons/rifle/nope", -1) == -1);
+	assert(kv->GetByPath("weapons/rifle/") == nullptr);
+
+	/* The cache must see through value changes */
+	auto* rifle = kv->GetChild("weapons")->GetChild("rifle");
+	rifle->SetInt("damage", 55);
+	assert(kv->GetIntByPath("weapons/rifle/damage") == 55);
+
+	/* Cursor walks keys and children without copies */
+	KeyValues::Cursor cur(kv->GetChild("weapons"));
+	int nchildren = 0;
+	while (auto* child = cur.NextChild())
+		nchildren += child->HasKey("damage");
+	assert(nchildren == 2);
+	assert(cur.NextKey() == nullptr); /* "weapons" holds only sections */
+
+	KeyValues::Cursor kcur(rifle);
+	int nkeys = 0;
+	const KeyValues::Key* k;
+	while ((k = kcur.NextKey()) != nullptr) {
+		assert(k == &rifle->Keys()[nkeys]); /* By pointer, not by value */
+		nkeys++;
+	}
+	assert(nkeys == 2);
+	kcur.Reset();
+	assert(kcur.NextKey() == &rifle->Keys()[0]);
+
+	delete kv;
+}
+
+static void kv_clonetest1() {
+	T_TESTCASE();
+
+	auto* src = KeyValues::FromString(
+		"cfg\n{\n\t\"host\" \"example\"\n\t\"port\" \"80\"\n\tnet\n\t{\n\t\t\"mtu\" \"1500\"\n\t}\n}\n");
+	assert(src);
+	src->GetChild("cfg")->GetInt("port"); /* Warm a numeric cache; it must carry over */
+
+	auto* a = src->Clone();
+	auto* b = src->Clone();
+	delete src; /* Clones must be fully independent of the source */
+
+	auto* acfg = a->GetChild("cfg");
+	auto* bcfg = b->GetChild("cfg");
+	assert(strcmp(acfg->GetString("host"), "example") == 0);
+	assert(acfg->GetInt("port") == 80);
+	assert(acfg->GetChild("net")->GetInt("mtu") == 1500);
+	assert(acfg->Keys()[1].cached == KeyValues::Key::ELastCached::INT);
+
+	/* And of each other */
+	bcfg->SetString("host", "other");
+	assert(strcmp(acfg->GetString("host"), "example") == 0);
+	assert(strcmp(bcfg->GetString("host"), "other") == 0);
+
+	/* A clone of a clone works too */
+	auto* c = b->Clone();
+	delete b;
+	assert(strcmp(c->GetChild("cfg")->GetString("host"), "other") == 0);
+
+	delete a;
+	delete c;
+}
+
+static void kv_buildtest1() {
+	T_TESTCASE();
+
+	auto* kv = new KeyValues("root");
+	kv->Reserve(128);
+	assert(kv->Keys().capacity() >= 128);
+	const KeyValues::Key* base = kv->Keys().data();
+
+	char buf[32];
+	for (int i = 0; i < 128; i++) {
+		snprintf(buf, sizeof(buf), "key_%d", i);
+		if (i & 1) {
+			/* Odd keys hand over malloc'd buffers, no copy */
+			char* v = (char*)malloc(16);
+			snprintf(v, 16, "%d", i * 10);
+			kv->AddKeyOwned(strdup(buf), v);
+		}
+		else {
+			snprintf(buf + 16, sizeof(buf) - 16, "%d", i * 10);
+			kv->AddKey(buf, buf + 16);
+		}
+	}
+	/* Reserve held: no reallocation happened while appending */
+	assert(kv->Keys().data() == base);
+
+	assert(kv->GetInt("key_0") == 0);
+	assert(kv->GetInt("key_7") == 70);
+	assert(kv->GetInt("key_127") == 1270);
+	assert(strcmp(kv->GetString("key_64"), "640") == 0);
+
+	/* SetStringOwned adopts the replacement buffer; on a missing key it frees it */
+	kv->SetStringOwned("key_3", strdup("replaced"));
+	assert(strcmp(kv->GetString("key_3"), "replaced") == 0);
+	kv->SetStringOwned("no_such_key", strdup("dropped"));
+	assert(!kv->HasKey("no_such_key"));
+
+	auto* net = kv->AddChild("net");
+	net->AddKey("mtu", "1500");
+	assert(kv->GetChild("net") == net);
+	assert(kv->GetChild("net")->GetInt("mtu") == 1500);
+
+	delete kv;
+}
+
+static void kv_freezetest1() {
+	T_TESTCASE();
+
+	/* Enough keys to push the section past the lazy index threshold */
+	auto* kv = new KeyValues("root");
+	kv->Reserve(64);
+	char name[32], val[32];
+	for (int i = 0; i < 64; i++) {
+		snprintf(name, sizeof(name), "key_%d", i);
+		snprintf(val, sizeof(val), "%d", i * 3);
+		kv->AddKey(name, val);
+	}
+	kv->AddKey("ratio", "2.5");
+	kv->AddKey("enabled", "true");
+	kv->AddKey("label", "hello");
+	auto* net = kv->AddChild("net");
+	net->AddKey("mtu", "1500");
+
+	assert(!kv->Frozen());
+	kv->Freeze();
+	assert(kv->Frozen());
+	assert(kv->GetChild("net")->Frozen());
+
+	/* Every getter flavor, including cross-type reads that miss the precached slot and
+	 * the by-path lookups that would otherwise populate the path cache */
+	auto readerChecks = [&]() {
+		for (int r = 0; r < 10000; r++) {
+			int i = r % 64;
+			char k[32];
+			snprintf(k, sizeof(k), "key_%d", i);
+			assert(kv->GetInt(k) == i * 3);
+			assert(kv->GetFloat(k) == (float)(i * 3));
+			assert(kv->GetDouble("ratio") == 2.5);
+			assert(kv->GetBool("enabled"));
+			assert(kv->GetBool("key_0") == false); /* "0" reads as false */
+			assert(strcmp(kv->GetString("label"), "hello") == 0);
+			assert(kv->GetIntByPath("net/mtu") == 1500);
+			assert(kv->GetInt("missing", -7) == -7);
+		}
+	};
+
+	std::thread readers[4];
+	for (auto& t : readers)
+		t = std::thread(readerChecks);
+	for (auto& t : readers)
+		t.join();
+
+	delete kv;
+}
+
+static void kv_interntest1() {
+	T_TESTCASE();
+
+	KeyValues::InternPool pool;
+	auto* a = KeyValues::FromString("one\n{\n\t\"model\" \"a.mdl\"\n\t\"texture\" \"a.vtf\"\n}\n", pool);
+	auto* b = KeyValues::FromString("two\n{\n\t\"model\" \"b.mdl\"\n\t\"texture\" \"b.vtf\"\n}\n", pool);
+	assert(a && b);
+
+	auto* one = a->GetChild("one");
+	auto* two = b->GetChild("two");
+	assert(strcmp(one->GetString("model"), "a.mdl") == 0);
+	assert(strcmp(two->GetString("model"), "b.mdl") == 0);
+
+	/* Identical key names across trees must share one pooled allocation */
+	assert(one->Keys()[0].key == two->Keys()[0].key);
+	assert(one->Keys()[0].keyId != 0);
+	assert(one->Keys()[0].keyId == two->Keys()[0].keyId);
+	/* "model", "texture", plus the section names (which pass through the key path) */
+	assert(pool.Size() == 4);
+	assert(pool.Find("model") == one->Keys()[0].keyId);
+	assert(pool.Find("never_seen") == 0);
+
+	delete a;
+	delete b;
+}
+
+static void kv_dumpbuffertest1() {
+	T_TESTCASE();
+
+	auto* kv = KeyValues::FromString(
+		"test\n{\n\t\"a\" \"1\"\n\tb two\n\t\"sub sec\"\n\t{\n\t\t\"c\" \"hello world\"\n\t}\n}\n");
+	assert(kv);
+
+	/* Buffered output must match the stdio path byte for byte */
+	std::string buf;
+	kv->DumpToBuffer(buf);
+
+	FILE* fs = tmpfile();
+	assert(fs);
+	kv->DumpToStream(fs);
+	long size = ftell(fs);
+	assert((size_t)size == buf.size());
+	rewind(fs);
+	std::string streamed(size, 0);
+	assert(fread(&streamed[0], 1, size, fs) == (size_t)size);
+	fclose(fs);
+	assert(buf == streamed);
+
+	/* And must round-trip */
+	auto* again = KeyValues::FromString(buf.c_str());
+	assert(again);
+	assert(strcmp(again->GetChild("test")->GetChild("sub sec")->GetString("c"), "hello world") == 0);
+	delete again;
+	delete kv;
+}
+
+static void kv_mergetest1() {
+	T_TESTCASE();
+
+	auto* base = KeyValues::FromString(
+		"cfg\n{\n\t\"host\" \"default\"\n\t\"port\" \"80\"\n\tnet\n\t{\n\t\t\"mtu\" \"1500\"\n\t}\n}\n");
+	auto* overlay = KeyValues::FromString(
+		"cfg\n{\n\t\"host\" \"eu-1\"\n\t\"region\" \"eu\"\n\tnet\n\t{\n\t\t\"mtu\" \"9000\"\n\t}\n"
+		"\ttls\n\t{\n\t\t\"cert\" \"a.pem\"\n\t}\n}\n");
+	assert(base && overlay);
+
+	/* The patch must contain exactly what changed */
+	auto* patch = base->Diff(*overlay);
+	auto* pcfg = patch->GetChild("cfg");
+	assert(pcfg);
+	assert(strcmp(pcfg->GetString("host"), "eu-1") == 0);
+	assert(strcmp(pcfg->GetString("region"), "eu") == 0);
+	assert(!pcfg->HasKey("port"));
+	assert(pcfg->GetChild("net")->GetInt("mtu") == 9000);
+	assert(pcfg->GetChild("tls"));
+
+	base->MergeFrom(*patch);
+	auto* cfg = base->GetChild("cfg");
+	assert(strcmp(cfg->GetString("host"), "eu-1") == 0);
+	assert(cfg->GetInt("port") == 80);
+	assert(strcmp(cfg->GetString("region"), "eu") == 0);
+	assert(cfg->GetChild("net")->GetInt("mtu") == 9000);
+	assert(strcmp(cfg->GetChild("tls")->GetString("cert"), "a.pem") == 0);
+
+	/* After merging, nothing should differ anymore */
+	auto* empty = base->Diff(*overlay);
+	assert(empty->Keys().empty() && empty->SubKeys().empty());
+
+	delete empty;
+	delete patch;
+	delete overlay;
+	delete base;
+}
+
+static void kv_loadfilestest1() {
+	T_TESTCASE();
+
+	char names[8][32];
+	const char* paths[8];
+	for (int i = 0; i < 8; i++) {
+		snprintf(names[i], sizeof(names[i]), "loadfiles_%d.kv", i);
+		paths[i] = names[i];
+		FILE* fs = fopen(names[i], "w");
+		assert(fs);
+		fprintf(fs, "test\n{\n\t\"idx\" \"%d\"\n}\n", i);
+		fclose(fs);
+	}
+	/* One bogus path; its slot must come back null without disturbing the rest */
+	paths[3] = "loadfiles_missing.kv";
+
+	auto trees = KeyValues::LoadFiles(paths, 8, 4);
+	assert(trees.size() == 8);
+	for (int i = 0; i < 8; i++) {
+		if (i == 3) {
+			assert(trees[i] == nullptr);
+			continue;
+		}
+		assert(trees[i]);
+		assert(trees[i]->GetChild("test")->GetInt("idx") == i);
+		delete trees[i];
+	}
+
+	for (int i = 0; i < 8; i++)
+		remove(names[i]);
+
+	/* A batch wider than the read window, so the read stage has to recycle in-flight
+	 * slots; empty files must come back as valid empty trees, not nulls */
+	constexpr int BATCH = 200;
+	static char bnames[BATCH][32];
+	const char* bpaths[BATCH];
+	for (int i = 0; i < BATCH; i++) {
+		snprintf(bnames[i], sizeof(bnames[i]), "loadfiles_b%d.kv", i);
+		bpaths[i] = bnames[i];
+		FILE* fs = fopen(bnames[i], "w");
+		assert(fs);
+		if (i != 100) /* One empty file in the middle */
+			fprintf(fs, "test\n{\n\t\"idx\" \"%d\"\n}\n", i);
+		fclose(fs);
+	}
+	auto btrees = KeyValues::LoadFiles(bpaths, BATCH, 4);
+	for (int i = 0; i < BATCH; i++) {
+		assert(btrees[i]);
+		if (i != 100)
+			assert(btrees[i]->GetChild("test")->GetInt("idx") == i);
+		delete btrees[i];
+		remove(bnames[i]);
+	}
+}
+
+static void kv_streamtest1() {
+	T_TESTCASE();
+
+	const char* src =
+		"// header comment\n"
+		"test\n{\n\t\"a\" \"1\"\n\tb 2 // trailing comment\n"
+		"\tsub\n\t{\n\t\t\"c\" \"hello\"\n\t}\n}\n";
+	size_t len = strlen(src);
+
+	/* Deliberately awkward chunk sizes to cross every token boundary */
+	for (size_t chunk = 1; chunk <= 7; chunk += 3) {
+		KeyValues::Parser parser;
+		for (size_t i = 0; i < len; i += chunk)
+			assert(parser.Feed(src + i, i + chunk > len ? len - i : chunk));
+
+		auto* kv = parser.Finish();
+		assert(kv);
+
+		auto* test = kv->GetChild("test");
+		assert(test);
+		assert(test->GetInt("a") == 1);
+		assert(test->GetInt("b") == 2);
+		auto* sub = test->GetChild("sub");
+		assert(sub);
+		assert(strcmp(sub->GetString("c"), "hello") == 0);
+		delete kv;
+	}
+
+	/* Unterminated section must fail cleanly */
+	{
+		KeyValues::Parser parser;
+		const char* bad = "test\n{\n\t\"a\" \"1\"\n";
+		assert(parser.Feed(bad, strlen(bad)));
+		assert(parser.Finish() == nullptr);
+	}
+}
+
+static void kv_compiledtest1() {
+	T_TESTCASE();
+
+	auto* kv = KeyValues::FromString(
+		"test\n{\n\t\"a\" \"1\"\n\t\"f\" \"1.5\"\n\t\"s\" \"hello\"\n\t\"b\" \"true\"\n"
+		"\tsub\n\t{\n\t\t\"c\" \"42\"\n\t}\n}\n");
+	assert(kv);
+	assert(kv->CompileToFile("compiled_test.kvb"));
+	delete kv;
+
+	KeyValues::Compiled compiled;
+	assert(compiled.Load("compiled_test.kvb"));
+	assert(compiled.Good());
+
+	auto test = compiled.Root().GetChild("test");
+	assert(test.Valid());
+	assert(test.GetInt("a") == 1);
+	assert(test.GetFloat("f") == 1.5f);
+	assert(strcmp(test.GetString("s"), "hello") == 0);
+	assert(test.GetBool("b") == true);
+	assert(!test.HasKey("nope"));
+
+	auto sub = test.GetChild("sub");
+	assert(sub.Valid());
+	assert(sub.GetInt("c") == 42);
+	assert(!sub.GetChild("nothing").Valid());
+
+	/* A corrupted file must fail Load, not crash later in View. Flip individual
+	 * record fields to out-of-range values and try again */
+	FILE* fs = fopen("compiled_test.kvb", "rb");
+	assert(fs);
+	fseek(fs, 0, SEEK_END);
+	long sz = ftell(fs);
+	fseek(fs, 0, SEEK_SET);
+	std::vector<char> good(sz);
+	assert(fread(good.data(), sz, 1, fs) == 1);
+	fclose(fs);
+
+	auto writeCorrupt = [&](size_t offset, uint32_t value) {
+		std::vector<char> bad = good;
+		memcpy(bad.data() + offset, &value, sizeof(value));
+		FILE* out = fopen("compiled_bad.kvb", "wb");
+		assert(out);
+		assert(fwrite(bad.data(), bad.size(), 1, out) == 1);
+		fclose(out);
+		KeyValues::Compiled c;
+		assert(!c.Load("compiled_bad.kvb"));
+		assert(!c.Good());
+	};
+
+	/* Header is 6 uint32s, nodes follow; node 0's fields in order are
+	 * name, nameHash, firstKey, numKeys, firstChild, numChildren */
+	const size_t node0 = 6 * sizeof(uint32_t);
+	writeCorrupt(node0 + 0 * sizeof(uint32_t), 0xFFFFFFFF);  /* name past the string table */
+	writeCorrupt(node0 + 3 * sizeof(uint32_t), 0xFFFFFFFF);  /* numKeys past the key array */
+	writeCorrupt(node0 + 4 * sizeof(uint32_t), 0xFFFFFFFF);  /* firstChild past the node array */
+	writeCorrupt(node0 + 5 * sizeof(uint32_t), 0xFFFFFFFF);  /* numChildren wraps firstChild */
+
+	/* Key 0's value offset, past the node array (6 uint32s per node) */
+	uint32_t numNodes;
+	memcpy(&numNodes, good.data() + 2 * sizeof(uint32_t), sizeof(numNodes));
+	const size_t key0 = node0 + numNodes * 6 * sizeof(uint32_t);
+	writeCorrupt(key0 + 1 * sizeof(uint32_t), 0xFFFFFFFF);
+
+	remove("compiled_bad.kvb");
+	remove("compiled_test.kvb");
+}
+
+static void kv_indextest1() {
+	T_TESTCASE();
+
+	/* Enough keys to trip the lazy index build */
+	std::string src = "test\n{\n";
+	for (int i = 0; i < 100; i++) {
+		char line[64];
+		snprintf(line, sizeof(line), "\t\"key_%d\" \"%d\"\n", i, i);
+		src += line;
+	}
+	/* Duplicate key; the first occurrence must win, like the linear scan */
+	src += "\t\"key_5\" \"9999\"\n";
+	src += "}\n";
+
+	auto* kv = KeyValues::FromString(src.c_str());
+	assert(kv);
+	auto* test = kv->GetChild("test");
+	assert(test);
+
+	for (int i = 0; i < 100; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "key_%d", i);
+		assert(test->GetInt(name) == i);
+	}
+	assert(test->GetInt("key_5") == 5);
+	assert(!test->HasKey("no_such_key"));
+
+	/* Explicit rebuild must not change results */
+	test->BuildIndex(true);
+	assert(test->GetInt("key_42") == 42);
+
+	delete kv;
+}
+
+static void kv_insitutest1() {
+	T_TESTCASE();
+
+	const char src[] = "test\n{\n\t\"a\" \"1\"\n\tb 2\n\tsub\n\t{\n\t\t\"c\" \"hello\"\n\t}\n}\n";
+	char* data = (char*)malloc(sizeof(src));
+	memcpy(data, src, sizeof(src));
+
+	auto* kv = KeyValues::FromBuffer(data, sizeof(src) - 1, true);
+	assert(kv);
+
+	auto* test = kv->GetChild("test");
+	assert(test);
+	assert(test->GetInt("a") == 1);
+	assert(test->GetInt("b") == 2);
+
+	auto* sub = test->GetChild("sub");
+	assert(sub);
+	assert(strcmp(sub->GetString("c"), "hello") == 0);
+
+	/* Tokens must point into the source buffer, not fresh allocations */
+	const char* v = sub->GetString("c");
+	assert(v >= data && v < data + sizeof(src));
+
+	/* Mutation swaps in heap values the tree must release despite being in-situ;
+	 * replacing a replaced value must free the first replacement too */
+	sub->SetString("c", "world");
+	assert(strcmp(sub->GetString("c"), "world") == 0);
+	sub->SetString("c", "again");
+	test->ClearKey("a");
+	assert(strcmp(test->GetString("a"), "") == 0);
+
+	delete kv; /* Frees the adopted buffer too */
+}
+
+static void kv_arenatest1() {
+	T_TESTCASE();
+
+	KeyValues::Arena arena;
+	auto* kv = KeyValues::FromString("test\n{\n\t\"a\" \"1\"\n\tsub\n\t{\n\t\t\"b\" \"2\"\n\t}\n}\n", arena);
+	assert(kv);
+
+	auto* test = kv->GetChild("test");
+	assert(test);
+	assert(test->GetInt("a") == 1);
+
+	auto* sub = test->GetChild("sub");
+	assert(sub);
+	assert(sub->GetInt("b") == 2);
+
+	delete kv;
+	/* All string/node storage is released with the arena */
+}
+
 static void kv_perftest1() {
 	T_TESTCASE();
 
@@ -26,4 +797,6 @@ static void kv_perftest1() {
 	assert(kv);
 	timer.end();
 	timer.display();
+
+	delete kv;
 }